@@ -0,0 +1,125 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	/* required for the cpu_set_t macros and sched_setaffinity */
+#	define _GNU_SOURCE
+#endif
+
+#include "affinity.h"
+#include "memutils.h"
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+#	include <Windows.h>
+#	include <process.h>
+#else
+#	include <pthread.h>
+#	if defined(QSC_SYSTEM_OS_LINUX)
+#		include <sched.h>
+#	endif
+#endif
+
+#if !defined(QSC_SYSTEM_OS_WINDOWS)
+typedef struct affinity_thread_start
+{
+	void (*func)(void*);
+	void* state;
+} affinity_thread_start;
+
+static void* affinity_thread_run(void* start)
+{
+	affinity_thread_start tstart;
+
+	/* the start record is owned by the new thread */
+	tstart = *(affinity_thread_start*)start;
+	qsc_memutils_alloc_free(start);
+	tstart.func(tstart.state);
+
+	return NULL;
+}
+#endif
+
+size_t siap_affinity_worker_processor(size_t index)
+{
+	size_t pcnt;
+
+	pcnt = qsc_async_processor_count();
+	pcnt = (pcnt != 0U) ? pcnt : 1U;
+
+	return index % pcnt;
+}
+
+bool siap_affinity_pin_thread(size_t processor)
+{
+#if defined(QSC_SYSTEM_OS_LINUX)
+	cpu_set_t cset;
+#endif
+	bool res;
+
+	res = false;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	if (processor < (sizeof(DWORD_PTR) * 8U))
+	{
+		res = (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1U << processor) != 0U);
+	}
+#elif defined(QSC_SYSTEM_OS_LINUX)
+	if (processor < (size_t)CPU_SETSIZE)
+	{
+		CPU_ZERO(&cset);
+		CPU_SET(processor, &cset);
+		/* a zero thread id selects the calling thread */
+		res = (sched_setaffinity(0, sizeof(cset), &cset) == 0);
+	}
+#else
+	(void)processor;
+#endif
+
+	return res;
+}
+
+bool siap_affinity_thread_create(qsc_thread* thread, void (*func)(void*), void* state)
+{
+	SIAP_ASSERT(thread != NULL);
+	SIAP_ASSERT(func != NULL);
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	uintptr_t hthd;
+#else
+	affinity_thread_start* start;
+	pthread_t hthd;
+#endif
+	bool res;
+
+	res = false;
+
+	if (thread != NULL && func != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+		hthd = _beginthread(func, 0U, state);
+
+		if (hthd != (uintptr_t)-1L && hthd != 0U)
+		{
+			*thread = (qsc_thread)hthd;
+			res = true;
+		}
+#else
+		start = (affinity_thread_start*)qsc_memutils_malloc(sizeof(affinity_thread_start));
+
+		if (start != NULL)
+		{
+			start->func = func;
+			start->state = state;
+
+			if (pthread_create(&hthd, NULL, &affinity_thread_run, start) == 0)
+			{
+				*thread = hthd;
+				res = true;
+			}
+			else
+			{
+				qsc_memutils_alloc_free(start);
+			}
+		}
+#endif
+	}
+
+	return res;
+}
@@ -0,0 +1,102 @@
+/* 2025-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SIAP_AFFINITY_H
+#define SIAP_AFFINITY_H
+
+#include "siapcommon.h"
+#include "async.h"
+
+/**
+* \file affinity.h
+* \brief SIAP worker thread creation and placement.
+*
+* \details
+* Starts worker threads with a result the caller can check; \c qsc_async_thread_create does not report a failed start,
+* and waiting on a thread that was never created is undefined.
+* Pins the calling thread to a processor. Memory is placed on the NUMA node of the thread that first writes it,
+* so a pinned worker that allocates and clears its own workspace, and that computes its SCB hashes on its own thread,
+* works on node-local memory. Pinning is supported on Windows and Linux; on other systems the functions report
+* failure and the workers run unpinned.
+*/
+
+/**
+ * \brief Get the processor a worker is placed on.
+ * Workers are placed on consecutive processors, wrapping at the processor count.
+ *
+ * \param index The worker index.
+ *
+ * \return Returns the processor index.
+ */
+SIAP_EXPORT_API size_t siap_affinity_worker_processor(size_t index);
+
+/**
+ * \brief Pin the calling thread to a processor.
+ *
+ * \param processor The processor index.
+ *
+ * \return Returns false if the thread could not be pinned, or pinning is not supported on this system.
+ */
+SIAP_EXPORT_API bool siap_affinity_pin_thread(size_t processor);
+
+/**
+ * \brief Start a thread.
+ * A started thread is waited on with \c qsc_async_thread_wait or \c qsc_async_thread_wait_all.
+ *
+ * \param thread A pointer to the thread handle, set only when the thread starts.
+ * \param func The thread function.
+ * \param state The thread function state.
+ *
+ * \return Returns false if the thread could not be started.
+ */
+SIAP_EXPORT_API bool siap_affinity_thread_create(qsc_thread* thread, void (*func)(void*), void* state);
+
+#endif
@@ -0,0 +1,299 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	/* required for the anonymous, huge page, and advice mapping flags */
+#	define _GNU_SOURCE
+#endif
+
+#include "arena.h"
+#include "memutils.h"
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+#	include <Windows.h>
+#elif defined(QSC_SYSTEM_OS_POSIX)
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+static size_t arena_round(size_t length, size_t unit)
+{
+	return ((length + unit - 1U) / unit) * unit;
+}
+
+static bool arena_map(siap_secure_arena* arena, size_t length)
+{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	SYSTEM_INFO sinf;
+	SIZE_T lpsize;
+#elif defined(QSC_SYSTEM_OS_POSIX)
+	void* pmem;
+#endif
+	bool res;
+
+	res = false;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	lpsize = GetLargePageMinimum();
+
+	if (lpsize != 0U && length >= (size_t)lpsize)
+	{
+		/* large pages need the lock memory privilege, and are never paged out */
+		arena->rlength = arena_round(length, (size_t)lpsize);
+		arena->region = (uint8_t*)VirtualAlloc(NULL, arena->rlength, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		arena->huge = (arena->region != NULL);
+		arena->locked = arena->huge;
+	}
+
+	if (arena->region == NULL)
+	{
+		GetSystemInfo(&sinf);
+		arena->rlength = arena_round(length, (size_t)sinf.dwPageSize);
+		arena->region = (uint8_t*)VirtualAlloc(NULL, arena->rlength, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+		if (arena->region != NULL)
+		{
+			arena->locked = (VirtualLock(arena->region, arena->rlength) != 0);
+		}
+	}
+
+	res = (arena->region != NULL);
+#elif defined(QSC_SYSTEM_OS_POSIX)
+	pmem = MAP_FAILED;
+
+#	if defined(MAP_HUGETLB)
+	if (length >= SIAP_ARENA_HUGE_PAGE_SIZE)
+	{
+		/* fails unless the system has huge pages reserved */
+		arena->rlength = arena_round(length, SIAP_ARENA_HUGE_PAGE_SIZE);
+		pmem = mmap(NULL, arena->rlength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		arena->huge = (pmem != MAP_FAILED);
+	}
+#	endif
+
+	if (pmem == MAP_FAILED)
+	{
+		arena->rlength = arena_round(length, (size_t)sysconf(_SC_PAGESIZE));
+		pmem = mmap(NULL, arena->rlength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+#	if defined(MADV_HUGEPAGE)
+		/* ask for transparent huge pages instead */
+		if (pmem != MAP_FAILED && arena->rlength >= SIAP_ARENA_HUGE_PAGE_SIZE)
+		{
+			arena->huge = (madvise(pmem, arena->rlength, MADV_HUGEPAGE) == 0);
+		}
+#	endif
+	}
+
+	if (pmem != MAP_FAILED)
+	{
+		arena->region = (uint8_t*)pmem;
+
+#	if defined(MADV_DONTDUMP)
+		/* keep the key material out of core dumps */
+		(void)madvise(pmem, arena->rlength, MADV_DONTDUMP);
+#	endif
+
+		arena->locked = (mlock(pmem, arena->rlength) == 0);
+		res = true;
+	}
+#else
+	(void)length;
+#endif
+
+	arena->mapped = res;
+
+	return res;
+}
+
+static void arena_unmap(siap_secure_arena* arena)
+{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	if (arena->locked == true && arena->huge == false)
+	{
+		(void)VirtualUnlock(arena->region, arena->rlength);
+	}
+
+	(void)VirtualFree(arena->region, 0U, MEM_RELEASE);
+#elif defined(QSC_SYSTEM_OS_POSIX)
+	if (arena->locked == true)
+	{
+		(void)munlock(arena->region, arena->rlength);
+	}
+
+	(void)munmap(arena->region, arena->rlength);
+#else
+	(void)arena;
+#endif
+}
+
+static bool arena_release(siap_secure_arena* arena, void* slot, bool erase)
+{
+	size_t offset;
+	size_t sidx;
+	bool res;
+
+	res = false;
+
+	if (arena != NULL && arena->mutex != NULL && slot != NULL &&
+		(uint8_t*)slot >= arena->region && (uint8_t*)slot < arena->region + (arena->ssize * arena->scount))
+	{
+		offset = (size_t)((uint8_t*)slot - arena->region);
+
+		if (offset % arena->ssize == 0U)
+		{
+			sidx = offset / arena->ssize;
+			qsc_async_mutex_lock(arena->mutex);
+
+			/* a slot that is not in use, one already released, is not pushed a second time */
+			if (arena->sused[sidx] == true)
+			{
+				/* the slot is erased before another caller can take it */
+				if (erase == true)
+				{
+					qsc_memutils_secure_erase(slot, arena->ssize);
+				}
+
+				arena->sused[sidx] = false;
+				arena->sfree[arena->fcount] = sidx;
+				++arena->fcount;
+				res = true;
+			}
+
+			qsc_async_mutex_unlock(arena->mutex);
+		}
+	}
+
+	return res;
+}
+
+void* siap_arena_acquire(siap_secure_arena* arena)
+{
+	SIAP_ASSERT(arena != NULL);
+
+	uint8_t* slot;
+
+	slot = NULL;
+
+	if (arena != NULL && arena->mutex != NULL)
+	{
+		qsc_async_mutex_lock(arena->mutex);
+
+		if (arena->fcount != 0U)
+		{
+			--arena->fcount;
+			arena->sused[arena->sfree[arena->fcount]] = true;
+			slot = arena->region + (arena->sfree[arena->fcount] * arena->ssize);
+		}
+
+		qsc_async_mutex_unlock(arena->mutex);
+	}
+
+	return slot;
+}
+
+void siap_arena_dispose(siap_secure_arena* arena)
+{
+	if (arena != NULL)
+	{
+		if (arena->region != NULL)
+		{
+			/* the whole region is erased once, rather than slot by slot */
+			qsc_memutils_secure_erase(arena->region, arena->rlength);
+
+			if (arena->mapped == true)
+			{
+				arena_unmap(arena);
+			}
+			else
+			{
+				qsc_memutils_aligned_free(arena->region);
+			}
+		}
+
+		if (arena->sfree != NULL)
+		{
+			qsc_memutils_alloc_free(arena->sfree);
+		}
+
+		if (arena->sused != NULL)
+		{
+			qsc_memutils_alloc_free(arena->sused);
+		}
+
+		if (arena->mutex != NULL)
+		{
+			qsc_async_mutex_destroy(arena->mutex);
+		}
+
+		qsc_memutils_clear(arena, sizeof(siap_secure_arena));
+	}
+}
+
+bool siap_arena_initialize(siap_secure_arena* arena, size_t ssize, size_t scount)
+{
+	SIAP_ASSERT(arena != NULL);
+	SIAP_ASSERT(ssize != 0U);
+	SIAP_ASSERT(scount != 0U);
+
+	size_t length;
+	bool res;
+
+	res = false;
+
+	if (arena != NULL && ssize != 0U && scount != 0U)
+	{
+		qsc_memutils_clear(arena, sizeof(siap_secure_arena));
+		arena->ssize = arena_round(ssize, SIAP_ARENA_SLOT_ALIGNMENT);
+
+		if (scount <= SIZE_MAX / arena->ssize)
+		{
+			length = arena->ssize * scount;
+			arena->scount = scount;
+
+			/* without a system mapping the arena is ordinary aligned memory, and is not locked */
+			if (arena_map(arena, length) == false)
+			{
+				arena->rlength = length;
+				arena->region = (uint8_t*)qsc_memutils_aligned_alloc((int32_t)SIAP_ARENA_SLOT_ALIGNMENT, length);
+			}
+
+			arena->sfree = (size_t*)qsc_memutils_malloc(scount * sizeof(size_t));
+			arena->sused = (bool*)qsc_memutils_malloc(scount * sizeof(bool));
+			arena->mutex = qsc_async_mutex_create();
+			res = (arena->region != NULL && arena->sfree != NULL && arena->sused != NULL && arena->mutex != NULL);
+		}
+
+		if (res == true)
+		{
+			/* write every page now, so no slot is faulted in on the authentication path */
+			qsc_memutils_clear(arena->region, arena->rlength);
+
+			/* the lowest slots are handed out first */
+			for (size_t i = 0U; i < scount; ++i)
+			{
+				arena->sfree[i] = scount - 1U - i;
+				arena->sused[i] = false;
+			}
+
+			arena->fcount = scount;
+		}
+		else
+		{
+			siap_arena_dispose(arena);
+		}
+	}
+
+	return res;
+}
+
+bool siap_arena_release(siap_secure_arena* arena, void* slot)
+{
+	SIAP_ASSERT(arena != NULL);
+
+	return arena_release(arena, slot, true);
+}
+
+bool siap_arena_release_erased(siap_secure_arena* arena, void* slot)
+{
+	SIAP_ASSERT(arena != NULL);
+
+	return arena_release(arena, slot, false);
+}
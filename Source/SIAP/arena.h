@@ -0,0 +1,157 @@
+/* 2025-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SIAP_ARENA_H
+#define SIAP_ARENA_H
+
+#include "siapcommon.h"
+#include "async.h"
+
+/**
+* \file arena.h
+* \brief SIAP secure memory arena.
+*
+* \details
+* A fixed region of memory reserved once at server startup and divided into equal, cache-aligned slots for keys,
+* key trees, and scratch workspaces. The region is locked in memory so secrets are never written to swap, and it is
+* written through at creation so no page is faulted in on the authentication path.
+* On Linux the region is backed by huge pages when the system has them reserved, or else by transparent huge pages,
+* and on Windows by large pages when the process holds the lock memory privilege; either way fewer TLB entries
+* cover the key material. A released slot is erased before it can be handed out again, and the whole region
+* is erased once when the arena is disposed.
+*/
+
+/*!
+* \def SIAP_ARENA_HUGE_PAGE_SIZE
+* \brief The huge page size the arena region is rounded to when it is backed by huge pages.
+*/
+#define SIAP_ARENA_HUGE_PAGE_SIZE 2097152U
+
+/*!
+* \def SIAP_ARENA_SLOT_ALIGNMENT
+* \brief The alignment of every arena slot, a cache line.
+*/
+#define SIAP_ARENA_SLOT_ALIGNMENT 64U
+
+/*!
+ * \struct siap_secure_arena
+ * \brief A locked memory arena of fixed-size slots.
+ */
+SIAP_EXPORT_API typedef struct siap_secure_arena
+{
+	uint8_t* region;							/*!< The arena memory */
+	size_t rlength;								/*!< The region length in bytes */
+	size_t* sfree;								/*!< The stack of free slot indices */
+	bool* sused;								/*!< The slots in use, indexed by slot */
+	size_t fcount;								/*!< The number of free slots */
+	size_t scount;								/*!< The number of slots */
+	size_t ssize;								/*!< The slot size in bytes, a multiple of the slot alignment */
+	qsc_mutex mutex;							/*!< The slot stack mutex */
+	bool huge;									/*!< The region is backed by huge or large pages */
+	bool locked;								/*!< The region is locked in memory */
+	bool mapped;								/*!< The region was mapped from the system rather than allocated */
+} siap_secure_arena;
+
+/**
+ * \brief Take a slot from the arena.
+ * The slot is zeroed.
+ *
+ * \param arena A pointer to the arena.
+ *
+ * \return Returns the slot, or NULL if every slot is in use.
+ */
+SIAP_EXPORT_API void* siap_arena_acquire(siap_secure_arena* arena);
+
+/**
+ * \brief Erase the arena and release its memory.
+ * Every slot must have been released, or must no longer be used.
+ *
+ * \param arena A pointer to the arena.
+ */
+SIAP_EXPORT_API void siap_arena_dispose(siap_secure_arena* arena);
+
+/**
+ * \brief Reserve, lock, and pre-fault an arena.
+ * If the region cannot be locked, for example because the process memory lock limit is too low,
+ * the arena is still created and the \c locked member is false.
+ *
+ * \param arena A pointer to the arena.
+ * \param ssize The slot size in bytes, rounded up to \c SIAP_ARENA_SLOT_ALIGNMENT.
+ * \param scount The number of slots.
+ *
+ * \return Returns false if the region could not be reserved.
+ */
+SIAP_EXPORT_API bool siap_arena_initialize(siap_secure_arena* arena, size_t ssize, size_t scount);
+
+/**
+ * \brief Erase a slot and return it to the arena.
+ * A pointer that is not the start of a slot of this arena, or a slot that is not in use, is left unchanged,
+ * so a slot released twice is not handed out twice.
+ *
+ * \param arena A pointer to the arena.
+ * \param slot A slot taken from this arena, may be NULL.
+ *
+ * \return Returns false if the slot is not a slot of this arena in use.
+ */
+SIAP_EXPORT_API bool siap_arena_release(siap_secure_arena* arena, void* slot);
+
+/**
+ * \brief Return a slot the caller has already erased to the arena, without erasing it again.
+ * The whole slot must have been erased; otherwise this is \c siap_arena_release.
+ *
+ * \param arena A pointer to the arena.
+ * \param slot A slot taken from this arena, may be NULL.
+ *
+ * \return Returns false if the slot is not a slot of this arena in use.
+ */
+SIAP_EXPORT_API bool siap_arena_release_erased(siap_secure_arena* arena, void* slot);
+
+#endif
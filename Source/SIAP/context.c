@@ -0,0 +1,1221 @@
+#include "context.h"
+#include "affinity.h"
+#include "intutils.h"
+#include "keccakx.h"
+#include "memutils.h"
+#include <time.h>
+
+typedef struct context_batch_task
+{
+	siap_server_context* ctx;
+	uint8_t* dtoks;
+	siap_device_key* dkeys;
+	siap_device_tag* dtags;
+	const uint8_t* phashes;
+	siap_errors* errors;
+	size_t count;
+	size_t first;
+	size_t stride;
+	size_t slot;
+	bool started;
+	bool finished;
+	bool withdrawn;
+} context_batch_task;
+
+static uint64_t context_clock_us(void)
+{
+	struct timespec ts;
+
+	(void)timespec_get(&ts, TIME_UTC);
+
+	return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000ULL);
+}
+
+static void* context_allocate(siap_server_context* ctx, size_t length)
+{
+	void* mem;
+
+	/* arena slots are zeroed when they are taken */
+	if (ctx->arena != NULL)
+	{
+		mem = siap_arena_acquire(ctx->arena);
+	}
+	else
+	{
+		mem = qsc_memutils_malloc(length);
+
+		if (mem != NULL)
+		{
+			qsc_memutils_clear(mem, length);
+		}
+	}
+
+	return mem;
+}
+
+static void context_deallocate(siap_server_context* ctx, void* mem, size_t length)
+{
+	if (mem != NULL)
+	{
+		/* the arena erases a slot when it is released */
+		if (ctx->arena != NULL)
+		{
+			(void)siap_arena_release(ctx->arena, mem);
+		}
+		else
+		{
+			qsc_memutils_secure_erase(mem, length);
+			qsc_memutils_alloc_free(mem);
+		}
+	}
+}
+
+static siap_errors context_passphrase_hash(siap_server_context* ctx, siap_server_workspace* ws, uint8_t* phash, const siap_server_request* request)
+{
+	siap_errors err;
+	bool res;
+
+	/* screen the device before the passphrase hash is paid for */
+	err = siap_server_context_screen_workspace(ctx, ws, request->dkey, request->dtag);
+
+	if (err == siap_error_none)
+	{
+		if (ws != NULL)
+		{
+			res = siap_server_passphrase_hash_generate_scratch(phash, request->passphrase, request->passlen, request->dtag->cpucost, request->dtag->memcost, &ws->scratch);
+		}
+		else
+		{
+			res = siap_server_passphrase_hash_generate_costs(phash, request->passphrase, request->passlen, request->dtag->cpucost, request->dtag->memcost);
+		}
+
+		err = (res == true) ? siap_error_none : siap_error_invalid_input;
+	}
+
+	return err;
+}
+
+static void context_batch_run(context_batch_task* task, siap_server_workspace* ws)
+{
+	/* each stripe takes every stride'th device */
+	for (size_t i = task->first; i < task->count; i += task->stride)
+	{
+		task->errors[i] = siap_server_context_authenticate_workspace(task->ctx, ws, task->dtoks + (i * SIAP_AUTHENTICATION_TOKEN_SIZE),
+			&task->dkeys[i], &task->dtags[i], task->phashes + (i * SIAP_HASH_SIZE));
+	}
+}
+
+static void context_async_worker(void* state)
+{
+	siap_server_context* ctx;
+	siap_server_workspace* ws;
+	siap_server_pending item = { 0 };
+	uint8_t phash[SIAP_HASH_SIZE] = { 0U };
+	siap_errors err;
+	uint64_t start;
+	uint64_t elapsed;
+	size_t widx;
+	bool active;
+	bool found;
+	bool pinned;
+
+	ctx = (siap_server_context*)state;
+	active = true;
+
+	qsc_async_mutex_lock(ctx->qmutex);
+	widx = ctx->tnext;
+	++ctx->tnext;
+	pinned = ctx->pinned;
+	qsc_async_mutex_unlock(ctx->qmutex);
+
+	if (pinned == true)
+	{
+		(void)siap_affinity_pin_thread(siap_affinity_worker_processor(widx));
+	}
+
+	/* the worker's own workspace is taken after it is pinned, so a pinned worker's heap workspace is node-local;
+	   if it cannot be taken the worker borrows from the context pool */
+	ws = siap_server_context_acquire_workspace(ctx);
+
+	while (active == true)
+	{
+		found = false;
+		qsc_async_mutex_lock(ctx->qmutex);
+
+		if (ctx->qcount != 0U)
+		{
+			item = ctx->queue[ctx->qhead];
+			ctx->qhead = (ctx->qhead + 1U) % SIAP_SERVER_QUEUE_DEPTH;
+			--ctx->qcount;
+			found = true;
+
+			if (item.batch != NULL)
+			{
+				((context_batch_task*)item.batch)->started = true;
+			}
+		}
+		else
+		{
+			/* a stopped context is drained before the workers exit */
+			active = ctx->running;
+		}
+
+		qsc_async_mutex_unlock(ctx->qmutex);
+
+		if (found == true)
+		{
+			if (item.batch != NULL)
+			{
+				/* a batch stripe runs in the worker's workspace, the batch caller waits for it to finish */
+				context_batch_run((context_batch_task*)item.batch, ws);
+				qsc_async_mutex_lock(ctx->qmutex);
+				((context_batch_task*)item.batch)->finished = true;
+				qsc_async_mutex_unlock(ctx->qmutex);
+			}
+			else if (item.request != NULL)
+			{
+				start = context_clock_us();
+
+				/* a request that waited past its deadline is dropped before any decryption or passphrase work */
+				if (item.request->deadline != 0U && start / 1000U > item.request->deadline)
+				{
+					qsc_async_mutex_lock(ctx->qmutex);
+					++ctx->qshed;
+					qsc_async_mutex_unlock(ctx->qmutex);
+					item.callback(item.request, siap_error_deadline_expired, item.user);
+				}
+				else
+				{
+					if (item.request->passphrase != NULL)
+					{
+						/* the worker hashes the passphrase, the SCB state runs in its own workspace */
+						err = context_passphrase_hash(ctx, ws, phash, item.request);
+
+						if (err == siap_error_none)
+						{
+							err = siap_server_context_authenticate_workspace(ctx, ws, item.request->dtok, item.request->dkey, item.request->dtag, phash);
+						}
+
+						qsc_memutils_secure_erase(phash, sizeof(phash));
+					}
+					else
+					{
+						err = siap_server_context_authenticate_workspace(ctx, ws, item.request->dtok, item.request->dkey, item.request->dtag, item.request->phash);
+					}
+
+					elapsed = context_clock_us() - start;
+
+					qsc_async_mutex_lock(ctx->qmutex);
+
+					if (ctx->qservice == 0U)
+					{
+						ctx->qservice = elapsed;
+					}
+					else
+					{
+						ctx->qservice = ctx->qservice - (ctx->qservice >> SIAP_SERVER_SERVICE_WEIGHT) + (elapsed >> SIAP_SERVER_SERVICE_WEIGHT);
+					}
+
+					qsc_async_mutex_unlock(ctx->qmutex);
+					item.callback(item.request, err, item.user);
+				}
+			}
+		}
+		else if (active == true)
+		{
+			qsc_async_thread_sleep(SIAP_SERVER_WORKER_IDLE_MS);
+		}
+	}
+
+	siap_server_context_release_workspace(ctx, ws);
+}
+
+static size_t context_find_key(const siap_server_context* ctx, const uint8_t* sid)
+{
+	size_t kidx;
+
+	kidx = 0U;
+
+	while (kidx < SIAP_SERVER_CONTEXT_KEYS_MAX &&
+		(ctx->keys[kidx] == NULL || qsc_memutils_are_equal(ctx->keys[kidx]->skey.sid, sid, SIAP_SID_SIZE) == false))
+	{
+		++kidx;
+	}
+
+	return kidx;
+}
+
+static void context_scrub(siap_server_workspace* ws, const uint8_t* sid)
+{
+	/* busy workspaces are erased when released */
+	if (ws->active == false && qsc_memutils_are_equal(ws->pkey.skey.sid, sid, SIAP_SID_SIZE) == true)
+	{
+		siap_server_prepared_key_dispose(&ws->pkey);
+		ws->generation = 0U;
+	}
+}
+
+static void context_unlink(siap_server_context* ctx, siap_server_workspace* ws)
+{
+	siap_server_workspace** link;
+
+	link = &ctx->owned;
+
+	while (*link != NULL && *link != ws)
+	{
+		link = &(*link)->next;
+	}
+
+	if (*link != NULL)
+	{
+		*link = ws->next;
+	}
+
+	ws->next = NULL;
+}
+
+static size_t context_stripe(const uint8_t* did)
+{
+	uint32_t h;
+
+	/* FNV-1a over the device identity, the key counter is excluded so every key of a device maps to one lock */
+	h = 2166136261UL;
+
+	for (size_t i = 0U; i < SIAP_DID_SIZE; ++i)
+	{
+		h ^= did[i];
+		h *= 16777619UL;
+	}
+
+	return (size_t)(h & (SIAP_SERVER_LOCK_STRIPES - 1U));
+}
+
+static void context_lock_device(siap_server_context* ctx, const uint8_t* did)
+{
+	qsc_async_mutex_lock(ctx->locks[context_stripe(did)]);
+}
+
+static void context_unlock_device(siap_server_context* ctx, const uint8_t* did)
+{
+	qsc_async_mutex_unlock(ctx->locks[context_stripe(did)]);
+}
+
+static siap_errors context_acquire(siap_server_context* ctx, siap_server_workspace** ws, const uint8_t* kid, siap_server_workspace* owned)
+{
+	siap_errors err;
+	size_t kidx;
+	size_t widx;
+
+	*ws = NULL;
+	err = siap_error_identity_mismatch;
+
+	/* the server identity is the leading part of the device identity */
+	qsc_async_mutex_lock(ctx->mutex);
+	kidx = context_find_key(ctx, kid);
+
+	if (kidx < SIAP_SERVER_CONTEXT_KEYS_MAX)
+	{
+		if (owned != NULL)
+		{
+			/* a caller workspace is used in place of the pool */
+			*ws = owned;
+		}
+		else
+		{
+			widx = 0U;
+
+			while (widx < ctx->wcount && ctx->workspaces[widx]->active == true)
+			{
+				++widx;
+			}
+
+			if (widx < ctx->wcount)
+			{
+				*ws = ctx->workspaces[widx];
+			}
+			else
+			{
+				/* when every workspace is busy the call takes one from the context memory, and frees it on release */
+				*ws = (siap_server_workspace*)context_allocate(ctx, sizeof(siap_server_workspace));
+
+				if (*ws != NULL)
+				{
+					(*ws)->transient = true;
+				}
+			}
+		}
+
+		if (*ws != NULL)
+		{
+			(*ws)->active = true;
+
+			/* the cached key is refreshed only if the key set changed or the workspace last served another server */
+			if ((*ws)->generation != ctx->generation || qsc_memutils_are_equal((*ws)->pkey.skey.sid, kid, SIAP_SID_SIZE) == false)
+			{
+				qsc_memutils_copy(&(*ws)->pkey, ctx->keys[kidx], sizeof(siap_server_prepared_key));
+				(*ws)->generation = ctx->generation;
+			}
+
+			err = siap_error_none;
+		}
+		else
+		{
+			err = siap_error_server_overloaded;
+		}
+	}
+
+	qsc_async_mutex_unlock(ctx->mutex);
+
+	return err;
+}
+
+static void context_release(siap_server_context* ctx, siap_server_workspace* ws)
+{
+	if (ws->transient == true)
+	{
+		/* the workspace and its key copy are erased when it is freed */
+		context_deallocate(ctx, ws, sizeof(siap_server_workspace));
+	}
+	else
+	{
+		qsc_async_mutex_lock(ctx->mutex);
+
+		/* a key removed or replaced during the call is not left cached */
+		if (ws->generation != ctx->generation)
+		{
+			siap_server_prepared_key_dispose(&ws->pkey);
+			ws->generation = 0U;
+		}
+
+		ws->active = false;
+		qsc_async_mutex_unlock(ctx->mutex);
+	}
+}
+
+siap_errors siap_server_authenticate_async(siap_server_context* ctx, siap_server_request* request, siap_server_callback callback, void* user)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(request != NULL);
+	SIAP_ASSERT(callback != NULL);
+
+	uint64_t now;
+	uint64_t wait;
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (ctx != NULL && ctx->qmutex != NULL && request != NULL && callback != NULL)
+	{
+		now = context_clock_us() / 1000U;
+		qsc_async_mutex_lock(ctx->qmutex);
+
+		if (ctx->running == true)
+		{
+			/* the request starts once the requests ahead of it have been shared among the workers */
+			wait = (((uint64_t)ctx->qcount / ctx->tcount) + 1U) * ctx->qservice / 1000U;
+
+			if (request->deadline != 0U && now > request->deadline)
+			{
+				err = siap_error_deadline_expired;
+			}
+			else if (ctx->qcount >= SIAP_SERVER_QUEUE_DEPTH || (request->deadline != 0U && now + wait > request->deadline))
+			{
+				err = siap_error_server_overloaded;
+			}
+			else
+			{
+				siap_server_pending* item = &ctx->queue[(ctx->qhead + ctx->qcount) % SIAP_SERVER_QUEUE_DEPTH];
+
+				item->request = request;
+				item->batch = NULL;
+				item->callback = callback;
+				item->user = user;
+				++ctx->qcount;
+				err = siap_error_none;
+			}
+
+			ctx->qshed += (err != siap_error_none) ? 1U : 0U;
+		}
+
+		qsc_async_mutex_unlock(ctx->qmutex);
+	}
+
+	return err;
+}
+
+size_t siap_server_authenticate_batch(siap_server_context* ctx, uint8_t* dtoks, siap_device_key* dkeys, siap_device_tag* dtags, const uint8_t* phashes, siap_errors* errors, size_t count, size_t threads, uint64_t* rate)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(dtoks != NULL);
+	SIAP_ASSERT(dkeys != NULL);
+	SIAP_ASSERT(dtags != NULL);
+	SIAP_ASSERT(phashes != NULL);
+	SIAP_ASSERT(errors != NULL);
+
+	context_batch_task tasks[SIAP_SERVER_BATCH_THREADS_MAX] = { 0 };
+	struct timespec ts1;
+	struct timespec ts2;
+	uint64_t elapsed;
+	size_t acnt;
+	size_t hcount;
+	size_t tcount;
+	bool busy;
+
+	acnt = 0U;
+
+	if (rate != NULL)
+	{
+		*rate = 0U;
+	}
+
+	if (ctx != NULL && ctx->qmutex != NULL && dtoks != NULL && dkeys != NULL && dtags != NULL && phashes != NULL && errors != NULL && count != 0U)
+	{
+		(void)timespec_get(&ts1, TIME_UTC);
+		hcount = 0U;
+		qsc_async_mutex_lock(ctx->qmutex);
+
+		if (ctx->running == true)
+		{
+			/* the calling thread takes one stripe, the others are queued for the running context workers */
+			hcount = (threads != 0U) ? threads - 1U : ctx->tcount;
+			hcount = qsc_intutils_min(hcount, ctx->tcount);
+			hcount = qsc_intutils_min(hcount, SIAP_SERVER_BATCH_THREADS_MAX - 1U);
+			hcount = qsc_intutils_min(hcount, count - 1U);
+			hcount = qsc_intutils_min(hcount, SIAP_SERVER_QUEUE_DEPTH - ctx->qcount);
+		}
+
+		tcount = hcount + 1U;
+
+		for (size_t i = 0U; i < tcount; ++i)
+		{
+			tasks[i].ctx = ctx;
+			tasks[i].count = count;
+			tasks[i].dkeys = dkeys;
+			tasks[i].dtags = dtags;
+			tasks[i].dtoks = dtoks;
+			tasks[i].errors = errors;
+			tasks[i].first = i;
+			tasks[i].phashes = phashes;
+			tasks[i].stride = tcount;
+		}
+
+		for (size_t i = 1U; i < tcount; ++i)
+		{
+			siap_server_pending* item;
+
+			tasks[i].slot = (ctx->qhead + ctx->qcount) % SIAP_SERVER_QUEUE_DEPTH;
+			item = &ctx->queue[tasks[i].slot];
+			item->request = NULL;
+			item->batch = &tasks[i];
+			item->callback = NULL;
+			item->user = NULL;
+			++ctx->qcount;
+		}
+
+		qsc_async_mutex_unlock(ctx->qmutex);
+
+		context_batch_run(&tasks[0U], NULL);
+
+		if (hcount != 0U)
+		{
+			/* stripes still waiting behind other requests are withdrawn from the queue and run by the calling thread */
+			qsc_async_mutex_lock(ctx->qmutex);
+
+			for (size_t i = 1U; i < tcount; ++i)
+			{
+				if (tasks[i].started == false)
+				{
+					ctx->queue[tasks[i].slot].batch = NULL;
+					tasks[i].withdrawn = true;
+				}
+			}
+
+			qsc_async_mutex_unlock(ctx->qmutex);
+
+			for (size_t i = 1U; i < tcount; ++i)
+			{
+				if (tasks[i].withdrawn == true)
+				{
+					context_batch_run(&tasks[i], NULL);
+				}
+			}
+
+			/* the task array is on this stack, so the call waits for the stripes the workers took */
+			do
+			{
+				busy = false;
+				qsc_async_mutex_lock(ctx->qmutex);
+
+				for (size_t i = 1U; i < tcount; ++i)
+				{
+					busy = (tasks[i].started == true && tasks[i].finished == false) ? true : busy;
+				}
+
+				qsc_async_mutex_unlock(ctx->qmutex);
+
+				if (busy == true)
+				{
+					qsc_async_thread_sleep(SIAP_SERVER_WORKER_IDLE_MS);
+				}
+			}
+			while (busy == true);
+		}
+
+		(void)timespec_get(&ts2, TIME_UTC);
+
+		for (size_t i = 0U; i < count; ++i)
+		{
+			acnt += (errors[i] == siap_error_none) ? 1U : 0U;
+		}
+
+		if (rate != NULL)
+		{
+			/* elapsed microseconds, at least one */
+			elapsed = ((uint64_t)(ts2.tv_sec - ts1.tv_sec) * 1000000ULL) + (uint64_t)((ts2.tv_nsec - ts1.tv_nsec) / 1000L);
+			elapsed = (elapsed != 0U) ? elapsed : 1U;
+			*rate = ((uint64_t)count * 1000000ULL) / elapsed;
+		}
+	}
+
+	return acnt;
+}
+
+uint64_t siap_server_clock_ms(void)
+{
+	return context_clock_us() / 1000U;
+}
+
+siap_server_workspace* siap_server_context_acquire_workspace(siap_server_context* ctx)
+{
+	SIAP_ASSERT(ctx != NULL);
+
+	siap_server_workspace* ws;
+
+	ws = NULL;
+
+	if (ctx != NULL && ctx->mutex != NULL)
+	{
+		ws = (siap_server_workspace*)context_allocate(ctx, sizeof(siap_server_workspace));
+
+		if (ws != NULL)
+		{
+			(void)siap_server_context_register_workspace(ctx, ws);
+		}
+	}
+
+	return ws;
+}
+
+bool siap_server_context_add_key(siap_server_context* ctx, const siap_server_key* skey)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(skey != NULL);
+
+	siap_server_prepared_key pkey = { 0 };
+	size_t kidx;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && ctx->mutex != NULL && skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		qsc_async_mutex_lock(ctx->mutex);
+		kidx = context_find_key(ctx, skey->sid);
+
+		if (kidx == SIAP_SERVER_CONTEXT_KEYS_MAX)
+		{
+			/* a new server identity takes the first free slot */
+			kidx = 0U;
+
+			while (kidx < SIAP_SERVER_CONTEXT_KEYS_MAX && ctx->keys[kidx] != NULL)
+			{
+				++kidx;
+			}
+
+			if (kidx < SIAP_SERVER_CONTEXT_KEYS_MAX)
+			{
+				ctx->keys[kidx] = (siap_server_prepared_key*)context_allocate(ctx, sizeof(siap_server_prepared_key));
+				kidx = (ctx->keys[kidx] != NULL) ? kidx : SIAP_SERVER_CONTEXT_KEYS_MAX;
+			}
+		}
+
+		if (kidx < SIAP_SERVER_CONTEXT_KEYS_MAX)
+		{
+			qsc_memutils_copy(ctx->keys[kidx], &pkey, sizeof(siap_server_prepared_key));
+			++ctx->generation;
+			res = true;
+		}
+
+		qsc_async_mutex_unlock(ctx->mutex);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+
+	return res;
+}
+
+siap_errors siap_server_context_authenticate_device(siap_server_context* ctx, uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const uint8_t* phash)
+{
+	return siap_server_context_authenticate_workspace(ctx, NULL, dtok, dkey, dtag, phash);
+}
+
+siap_errors siap_server_context_authenticate_segmented_key(siap_server_context* ctx, uint8_t* dtok, siap_segmented_key* dkey, siap_device_tag* dtag, const uint8_t* phash)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(dkey != NULL);
+
+	siap_server_workspace* ws;
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (ctx != NULL && ctx->mutex != NULL && dkey != NULL)
+	{
+		/* calls on the same device are serialized, so a token cannot be taken twice */
+		context_lock_device(ctx, dkey->kid);
+		err = context_acquire(ctx, &ws, dkey->kid, NULL);
+
+		if (err == siap_error_none)
+		{
+			err = siap_server_authenticate_segmented_key_scratch(dtok, dkey, dtag, &ws->pkey, phash, &ws->scratch);
+			context_release(ctx, ws);
+		}
+
+		context_unlock_device(ctx, dkey->kid);
+	}
+
+	return err;
+}
+
+siap_errors siap_server_context_authenticate_variable_key(siap_server_context* ctx, uint8_t* dtok, siap_variable_key* vkey, siap_device_tag* dtag, const uint8_t* phash)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(vkey != NULL);
+
+	siap_server_workspace* ws;
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (ctx != NULL && ctx->mutex != NULL && vkey != NULL)
+	{
+		/* calls on the same device are serialized, so a token cannot be taken twice */
+		context_lock_device(ctx, vkey->kid);
+		err = context_acquire(ctx, &ws, vkey->kid, NULL);
+
+		if (err == siap_error_none)
+		{
+			err = siap_server_authenticate_variable_key_scratch(dtok, vkey, dtag, &ws->pkey, phash, &ws->scratch);
+			context_release(ctx, ws);
+		}
+
+		context_unlock_device(ctx, vkey->kid);
+	}
+
+	return err;
+}
+
+siap_errors siap_server_context_authenticate_workspace(siap_server_context* ctx, siap_server_workspace* workspace, uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const uint8_t* phash)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(dkey != NULL);
+
+	siap_server_workspace* ws;
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (ctx != NULL && ctx->mutex != NULL && dkey != NULL)
+	{
+		/* calls on the same device are serialized, so a token cannot be taken twice */
+		context_lock_device(ctx, dkey->kid);
+		err = context_acquire(ctx, &ws, dkey->kid, workspace);
+
+		if (err == siap_error_none)
+		{
+			err = siap_server_authenticate_device_scratch(dtok, dkey, dtag, &ws->pkey, phash, &ws->scratch);
+			context_release(ctx, ws);
+		}
+
+		context_unlock_device(ctx, dkey->kid);
+	}
+
+	return err;
+}
+
+bool siap_server_context_decrypt_device_key(siap_server_context* ctx, siap_device_key* dkey, const uint8_t* phash)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(dkey != NULL);
+
+	siap_server_workspace* ws;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && ctx->mutex != NULL && dkey != NULL)
+	{
+		/* calls on the same device are serialized, so a token cannot be taken twice */
+		context_lock_device(ctx, dkey->kid);
+		if (context_acquire(ctx, &ws, dkey->kid, NULL) == siap_error_none)
+		{
+			res = siap_server_decrypt_device_key_prepared(dkey, &ws->pkey, phash);
+			context_release(ctx, ws);
+		}
+
+		context_unlock_device(ctx, dkey->kid);
+	}
+
+	return res;
+}
+
+void siap_server_context_dispose(siap_server_context* ctx)
+{
+	if (ctx != NULL)
+	{
+		siap_server_context_stop(ctx);
+
+		if (ctx->queue != NULL)
+		{
+			qsc_memutils_alloc_free(ctx->queue);
+			ctx->queue = NULL;
+		}
+
+		if (ctx->qmutex != NULL)
+		{
+			qsc_async_mutex_destroy(ctx->qmutex);
+			ctx->qmutex = NULL;
+		}
+
+		ctx->qhead = 0U;
+		ctx->qcount = 0U;
+		ctx->qservice = 0U;
+		ctx->qshed = 0U;
+
+		if (ctx->workspaces != NULL)
+		{
+			for (size_t i = 0U; i < ctx->wcount; ++i)
+			{
+				context_deallocate(ctx, ctx->workspaces[i], sizeof(siap_server_workspace));
+			}
+
+			qsc_memutils_alloc_free(ctx->workspaces);
+			ctx->workspaces = NULL;
+		}
+
+		for (size_t i = 0U; i < SIAP_SERVER_CONTEXT_KEYS_MAX; ++i)
+		{
+			context_deallocate(ctx, ctx->keys[i], sizeof(siap_server_prepared_key));
+			ctx->keys[i] = NULL;
+		}
+
+		if (ctx->mutex != NULL)
+		{
+			qsc_async_mutex_destroy(ctx->mutex);
+			ctx->mutex = NULL;
+		}
+
+		for (size_t i = 0U; i < SIAP_SERVER_LOCK_STRIPES; ++i)
+		{
+			if (ctx->locks[i] != NULL)
+			{
+				qsc_async_mutex_destroy(ctx->locks[i]);
+				ctx->locks[i] = NULL;
+			}
+		}
+
+		ctx->arena = NULL;
+		ctx->owned = NULL;
+		ctx->wcount = 0U;
+		ctx->generation = 0U;
+	}
+}
+
+bool siap_server_context_encrypt_device_key(siap_server_context* ctx, siap_device_key* dkey, const uint8_t* phash)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(dkey != NULL);
+
+	siap_server_workspace* ws;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && ctx->mutex != NULL && dkey != NULL)
+	{
+		/* calls on the same device are serialized, so a token cannot be taken twice */
+		context_lock_device(ctx, dkey->kid);
+		if (context_acquire(ctx, &ws, dkey->kid, NULL) == siap_error_none)
+		{
+			siap_server_encrypt_device_key_prepared(dkey, &ws->pkey, phash);
+			context_release(ctx, ws);
+			res = true;
+		}
+
+		context_unlock_device(ctx, dkey->kid);
+	}
+
+	return res;
+}
+
+bool siap_server_context_generate_authentication_token(siap_server_context* ctx, uint8_t* token, const siap_device_tag* dtag)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(dtag != NULL);
+
+	siap_server_workspace* ws;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && ctx->mutex != NULL && dtag != NULL)
+	{
+		if (context_acquire(ctx, &ws, dtag->kid, NULL) == siap_error_none)
+		{
+			res = siap_server_generate_authentication_token_prepared(token, dtag, &ws->pkey);
+			context_release(ctx, ws);
+		}
+	}
+
+	return res;
+}
+
+bool siap_server_context_generate_device_key(siap_server_context* ctx, siap_device_key* dkey, const uint8_t* did)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(did != NULL);
+
+	siap_server_workspace* ws;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && ctx->mutex != NULL && did != NULL)
+	{
+		if (context_acquire(ctx, &ws, did, NULL) == siap_error_none)
+		{
+			siap_server_generate_device_key_prepared(dkey, &ws->pkey, did);
+			context_release(ctx, ws);
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+bool siap_server_context_initialize(siap_server_context* ctx, size_t workspaces)
+{
+	return siap_server_context_initialize_arena(ctx, workspaces, NULL);
+}
+
+bool siap_server_context_initialize_arena(siap_server_context* ctx, size_t workspaces, siap_secure_arena* arena)
+{
+	SIAP_ASSERT(ctx != NULL);
+
+	size_t wlen;
+	bool res;
+
+	res = false;
+
+	/* the multi-buffer kernels derive every device key, so a faulty vector path must stop the server here */
+	if (ctx != NULL && (arena == NULL || arena->ssize >= sizeof(siap_server_workspace)) && siap_keccakx_self_test() == true)
+	{
+		qsc_memutils_clear(ctx, sizeof(siap_server_context));
+		ctx->arena = arena;
+
+		if (workspaces == 0U)
+		{
+			workspaces = qsc_async_processor_count();
+		}
+
+		ctx->wcount = qsc_intutils_min(qsc_intutils_max(workspaces, 1U), SIAP_SERVER_CONTEXT_WORKSPACES_MAX);
+		wlen = ctx->wcount * sizeof(siap_server_workspace*);
+		ctx->workspaces = (siap_server_workspace**)qsc_memutils_malloc(wlen);
+		/* the workspaces start at generation zero, so the first use copies the key */
+		ctx->generation = 1U;
+
+		if (ctx->workspaces != NULL)
+		{
+			qsc_memutils_clear(ctx->workspaces, wlen);
+			res = true;
+
+			for (size_t i = 0U; i < ctx->wcount; ++i)
+			{
+				ctx->workspaces[i] = (siap_server_workspace*)context_allocate(ctx, sizeof(siap_server_workspace));
+				res = (res == true && ctx->workspaces[i] != NULL);
+			}
+
+			ctx->mutex = qsc_async_mutex_create();
+			ctx->qmutex = qsc_async_mutex_create();
+			res = (res == true && ctx->mutex != NULL && ctx->qmutex != NULL);
+
+			for (size_t i = 0U; i < SIAP_SERVER_LOCK_STRIPES; ++i)
+			{
+				ctx->locks[i] = qsc_async_mutex_create();
+				res = (res == true && ctx->locks[i] != NULL);
+			}
+		}
+
+		if (res == false)
+		{
+			siap_server_context_dispose(ctx);
+		}
+	}
+
+	return res;
+}
+
+bool siap_server_context_issue_ticket(siap_server_context* ctx, siap_session_ticket* ticket, const uint8_t* dtok, const siap_device_tag* dtag, uint32_t lifetime)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(dtag != NULL);
+
+	siap_server_workspace* ws;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && ctx->mutex != NULL && dtag != NULL)
+	{
+		if (context_acquire(ctx, &ws, dtag->kid, NULL) == siap_error_none)
+		{
+			res = siap_server_issue_ticket(ticket, dtok, dtag, &ws->pkey, lifetime);
+			context_release(ctx, ws);
+		}
+	}
+
+	return res;
+}
+
+bool siap_server_context_register_workspace(siap_server_context* ctx, siap_server_workspace* workspace)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(workspace != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && ctx->mutex != NULL && workspace != NULL)
+	{
+		qsc_async_mutex_lock(ctx->mutex);
+		workspace->next = ctx->owned;
+		ctx->owned = workspace;
+		qsc_async_mutex_unlock(ctx->mutex);
+		res = true;
+	}
+
+	return res;
+}
+
+void siap_server_context_release_workspace(siap_server_context* ctx, siap_server_workspace* workspace)
+{
+	SIAP_ASSERT(ctx != NULL);
+
+	if (ctx != NULL && ctx->mutex != NULL && workspace != NULL)
+	{
+		qsc_async_mutex_lock(ctx->mutex);
+		context_unlink(ctx, workspace);
+		qsc_async_mutex_unlock(ctx->mutex);
+
+		/* the cached key is erased with the workspace memory */
+		context_deallocate(ctx, workspace, sizeof(siap_server_workspace));
+	}
+}
+
+bool siap_server_context_remove_key(siap_server_context* ctx, const uint8_t* sid)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(sid != NULL);
+
+	size_t kidx;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && ctx->mutex != NULL && sid != NULL)
+	{
+		qsc_async_mutex_lock(ctx->mutex);
+		kidx = context_find_key(ctx, sid);
+
+		if (kidx < SIAP_SERVER_CONTEXT_KEYS_MAX)
+		{
+			/* the key is erased as its memory is released */
+			context_deallocate(ctx, ctx->keys[kidx], sizeof(siap_server_prepared_key));
+			ctx->keys[kidx] = NULL;
+			++ctx->generation;
+
+			/* erase the cached copies in the idle pool and registered workspaces */
+			for (size_t i = 0U; i < ctx->wcount; ++i)
+			{
+				context_scrub(ctx->workspaces[i], sid);
+			}
+
+			for (siap_server_workspace* ws = ctx->owned; ws != NULL; ws = ws->next)
+			{
+				context_scrub(ws, sid);
+			}
+
+			res = true;
+		}
+
+		qsc_async_mutex_unlock(ctx->mutex);
+	}
+
+	return res;
+}
+
+siap_errors siap_server_context_screen_device(siap_server_context* ctx, const siap_device_key* dkey, const siap_device_tag* dtag)
+{
+	return siap_server_context_screen_workspace(ctx, NULL, dkey, dtag);
+}
+
+siap_errors siap_server_context_screen_workspace(siap_server_context* ctx, siap_server_workspace* workspace, const siap_device_key* dkey, const siap_device_tag* dtag)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(dkey != NULL);
+
+	siap_server_workspace* ws;
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (ctx != NULL && ctx->mutex != NULL && dkey != NULL)
+	{
+		context_lock_device(ctx, dkey->kid);
+		err = context_acquire(ctx, &ws, dkey->kid, workspace);
+
+		if (err == siap_error_none)
+		{
+			err = siap_server_screen_device(dkey, dtag, &ws->pkey);
+			context_release(ctx, ws);
+		}
+
+		context_unlock_device(ctx, dkey->kid);
+	}
+
+	return err;
+}
+
+bool siap_server_context_start(siap_server_context* ctx, size_t threads, bool pinned)
+{
+	SIAP_ASSERT(ctx != NULL);
+
+	size_t tcount;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && ctx->qmutex != NULL)
+	{
+		qsc_async_mutex_lock(ctx->qmutex);
+
+		if (ctx->running == false && ctx->workers == NULL)
+		{
+			tcount = (threads != 0U) ? threads : ctx->wcount;
+			tcount = qsc_intutils_min(qsc_intutils_max(tcount, 1U), SIAP_SERVER_BATCH_THREADS_MAX);
+
+			if (ctx->queue == NULL)
+			{
+				ctx->queue = (siap_server_pending*)qsc_memutils_malloc(SIAP_SERVER_QUEUE_DEPTH * sizeof(siap_server_pending));
+			}
+
+			ctx->workers = (qsc_thread*)qsc_memutils_malloc(tcount * sizeof(qsc_thread));
+
+			if (ctx->queue != NULL && ctx->workers != NULL)
+			{
+				ctx->running = true;
+				ctx->tcount = 0U;
+				ctx->tnext = 0U;
+				ctx->pinned = pinned;
+
+				/* only the workers that started are counted, so the queue estimate and stop see the running set */
+				for (size_t i = 0U; i < tcount; ++i)
+				{
+					if (siap_affinity_thread_create(&ctx->workers[ctx->tcount], &context_async_worker, ctx) == true)
+					{
+						++ctx->tcount;
+					}
+				}
+
+				res = (ctx->tcount != 0U);
+				ctx->running = res;
+			}
+
+			if (res == false && ctx->workers != NULL)
+			{
+				qsc_memutils_alloc_free(ctx->workers);
+				ctx->workers = NULL;
+			}
+		}
+
+		qsc_async_mutex_unlock(ctx->qmutex);
+	}
+
+	return res;
+}
+
+void siap_server_context_stop(siap_server_context* ctx)
+{
+	qsc_thread* workers;
+	size_t tcount;
+
+	if (ctx != NULL && ctx->qmutex != NULL)
+	{
+		/* refuse new requests, and take the worker set so a second stop does not wait on it */
+		qsc_async_mutex_lock(ctx->qmutex);
+		ctx->running = false;
+		workers = ctx->workers;
+		tcount = ctx->tcount;
+		ctx->workers = NULL;
+		ctx->tcount = 0U;
+		qsc_async_mutex_unlock(ctx->qmutex);
+
+		if (workers != NULL)
+		{
+			qsc_async_thread_wait_all(workers, tcount);
+			qsc_memutils_alloc_free(workers);
+		}
+	}
+}
+
+void siap_server_context_unregister_workspace(siap_server_context* ctx, siap_server_workspace* workspace)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(workspace != NULL);
+
+	if (ctx != NULL && ctx->mutex != NULL && workspace != NULL)
+	{
+		qsc_async_mutex_lock(ctx->mutex);
+		context_unlink(ctx, workspace);
+		siap_server_prepared_key_dispose(&workspace->pkey);
+		workspace->generation = 0U;
+		qsc_async_mutex_unlock(ctx->mutex);
+	}
+}
+
+siap_errors siap_server_context_verify_ticket(siap_server_context* ctx, const siap_session_ticket* ticket, const siap_device_tag* dtag)
+{
+	SIAP_ASSERT(ctx != NULL);
+	SIAP_ASSERT(ticket != NULL);
+	SIAP_ASSERT(dtag != NULL);
+
+	siap_server_workspace* ws;
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (ctx != NULL && ctx->mutex != NULL && ticket != NULL && dtag != NULL)
+	{
+		/* a ticket spends no token, so the device is not locked */
+		err = context_acquire(ctx, &ws, ticket->kid, NULL);
+
+		if (err == siap_error_none)
+		{
+			err = siap_server_verify_ticket(ticket, dtag, &ws->pkey);
+			context_release(ctx, ws);
+		}
+	}
+
+	return err;
+}
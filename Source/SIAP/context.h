@@ -0,0 +1,538 @@
+/* 2025-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SIAP_CONTEXT_H
+#define SIAP_CONTEXT_H
+
+#include "siapcommon.h"
+#include "arena.h"
+#include "server.h"
+#include "async.h"
+
+/**
+* \file context.h
+* \brief SIAP shared server context.
+*
+* \details
+* A server context owns the loaded server keys, prepared once when they are added, and a set of scratch workspaces
+* that each hold a cached copy of a prepared key. The context variants of the server functions select the server key
+* from the server identity at the start of the device key identity, borrow a workspace for the duration of the call,
+* and return it when the call completes.
+*
+* Thread safety:
+* - Every function except \c siap_server_context_initialize and \c siap_server_context_dispose may be called
+*   concurrently on the same context, from any thread. Keys may be added or removed while authentications are running;
+*   a call in progress completes with the key it started with.
+* - Calls that change a device key or tag take a lock selected by the device identity, from a table of
+*   \c SIAP_SERVER_LOCK_STRIPES locks; calls on the same device run one at a time, calls on other devices only wait
+*   when their identities share a lock. The lock is held only for the duration of the call, so a host that loads a
+*   card and stores it back after the call must still store the card and tag before the next call on that device reads them.
+* - When every workspace is in use, a call takes a workspace from the context memory for its duration instead of waiting;
+*   if that memory is exhausted, the call fails with \c siap_error_server_overloaded.
+*
+* A context initialized with \c siap_server_context_initialize_arena takes its prepared keys, its workspaces, and the
+* workspaces of its workers from a secure arena, so the key material is locked in memory and never allocated on the heap.
+*/
+
+/*!
+* \def SIAP_SERVER_BATCH_THREADS_MAX
+* \brief The maximum number of worker threads used by a batch authentication.
+*/
+#define SIAP_SERVER_BATCH_THREADS_MAX 64U
+
+/*!
+* \def SIAP_SERVER_CONTEXT_KEYS_MAX
+* \brief The maximum number of server keys held by a context.
+*/
+#define SIAP_SERVER_CONTEXT_KEYS_MAX 8U
+
+/*!
+* \def SIAP_SERVER_CONTEXT_WORKSPACES_MAX
+* \brief The maximum number of workspaces in a context.
+*/
+#define SIAP_SERVER_CONTEXT_WORKSPACES_MAX 256U
+
+/*!
+* \def SIAP_SERVER_LOCK_STRIPES
+* \brief The number of device locks in a context, a power of two.
+*/
+#define SIAP_SERVER_LOCK_STRIPES 256U
+
+/*!
+* \def SIAP_SERVER_QUEUE_DEPTH
+* \brief The number of asynchronous requests a context can hold waiting for a worker.
+*/
+#define SIAP_SERVER_QUEUE_DEPTH 1024U
+
+/*!
+* \def SIAP_SERVER_SERVICE_WEIGHT
+* \brief The weight, as a power of two, of the running average of the authentication service time;
+* each completed request moves the average by one part in 2^weight of its difference.
+*/
+#define SIAP_SERVER_SERVICE_WEIGHT 3U
+
+/*!
+* \def SIAP_SERVER_WORKER_IDLE_MS
+* \brief The time an idle asynchronous worker sleeps before checking the queue again, in milliseconds.
+*/
+#define SIAP_SERVER_WORKER_IDLE_MS 1U
+
+/*!
+ * \struct siap_server_workspace
+ * \brief A server context scratch workspace.
+ * The cached prepared key is only copied again when the context key set changes, or the workspace serves another server identity.
+ * Authentications run their temporaries in the workspace scratch, so a context call needs little stack.
+ */
+SIAP_EXPORT_API typedef struct siap_server_workspace
+{
+	siap_server_prepared_key pkey;				/*!< The cached prepared server key */
+	siap_server_scratch scratch;				/*!< The authentication temporaries */
+	struct siap_server_workspace* next;			/*!< The next registered caller workspace */
+	uint64_t generation;						/*!< The context key set generation the cached key was copied from */
+	bool active;								/*!< The workspace is in use by a call */
+	bool transient;								/*!< The workspace was taken for one call and is freed when it completes */
+} siap_server_workspace;
+
+/*!
+ * \struct siap_server_request
+ * \brief An asynchronous authentication request.
+ * The request, and the key, tag, and passphrase or passphrase hash it points to, must remain valid until its callback has been called.
+ * A request carrying the passphrase is screened, and the passphrase hashed with the tag costs in the worker's own workspace.
+ */
+SIAP_EXPORT_API typedef struct siap_server_request
+{
+	uint8_t dtok[SIAP_AUTHENTICATION_TOKEN_SIZE];	/*!< The output device token */
+	siap_device_key* dkey;						/*!< The device key */
+	siap_device_tag* dtag;						/*!< The device tag */
+	const uint8_t* phash;						/*!< The passphrase hash, unused when the passphrase is set */
+	const char* passphrase;						/*!< The passphrase, hashed by the worker; can be NULL */
+	size_t passlen;								/*!< The passphrase length */
+	uint64_t deadline;							/*!< The time by which the request must start, see \c siap_server_clock_ms, zero for none */
+} siap_server_request;
+
+/*!
+ * \brief The asynchronous authentication completion callback.
+ * Called on a context worker thread with the request, the authentication result, and the caller's user pointer.
+ * The device token is in the request when the result is \c siap_error_none.
+ * A request that reached a worker after its deadline is completed with \c siap_error_deadline_expired, without being authenticated.
+ */
+typedef void (*siap_server_callback)(siap_server_request* request, siap_errors error, void* user);
+
+/*!
+ * \struct siap_server_pending
+ * \brief A queued asynchronous authentication.
+ * A batch authentication queues its stripes in the same ring; an item withdrawn by its batch has neither a request nor a stripe.
+ */
+SIAP_EXPORT_API typedef struct siap_server_pending
+{
+	siap_server_request* request;				/*!< The request, NULL for a batch stripe */
+	void* batch;								/*!< The batch stripe, NULL for a request */
+	siap_server_callback callback;				/*!< The completion callback */
+	void* user;									/*!< The caller's user pointer */
+} siap_server_pending;
+
+/*!
+ * \struct siap_server_context
+ * \brief The SIAP shared server context.
+ */
+SIAP_EXPORT_API typedef struct siap_server_context
+{
+	siap_server_prepared_key* keys[SIAP_SERVER_CONTEXT_KEYS_MAX];	/*!< The prepared server keys, NULL for an empty slot */
+	siap_server_workspace** workspaces;			/*!< The scratch workspaces */
+	siap_server_workspace* owned;				/*!< The registered caller workspaces, erased with the pool when a key is removed */
+	size_t wcount;								/*!< The number of workspaces */
+	siap_secure_arena* arena;					/*!< The arena the keys and workspaces are taken from, NULL for the heap */
+	uint64_t generation;						/*!< The key set generation, incremented by every key change */
+	qsc_mutex mutex;							/*!< The key set and workspace mutex */
+	qsc_mutex locks[SIAP_SERVER_LOCK_STRIPES];	/*!< The device locks, selected by the device identity */
+	siap_server_pending* queue;					/*!< The asynchronous request ring */
+	size_t qhead;								/*!< The ring index of the oldest request */
+	size_t qcount;								/*!< The number of queued requests */
+	uint64_t qservice;							/*!< The running average authentication service time, in microseconds */
+	uint64_t qshed;								/*!< The number of requests refused or dropped under overload or past their deadline */
+	qsc_mutex qmutex;							/*!< The request queue mutex */
+	qsc_thread* workers;						/*!< The asynchronous worker threads */
+	size_t tcount;								/*!< The number of worker threads */
+	size_t tnext;								/*!< The index given to the next worker to start */
+	bool pinned;								/*!< The workers are pinned to processors */
+	bool running;								/*!< The workers are accepting requests */
+} siap_server_context;
+
+/**
+ * \brief Queue a device authentication on the context workers.
+ * The call returns without waiting; the callback is called on a worker thread when the authentication completes.
+ * The workers must have been started with \c siap_server_context_start.
+ * A request with a deadline is only admitted if the queued work ahead of it, at the average service time,
+ * can be done before its deadline, so the requests that are admitted wait a bounded time.
+ *
+ * \param ctx A pointer to the server context.
+ * \param request A pointer to the authentication request.
+ * \param callback The completion callback.
+ * \param user A caller pointer passed to the callback, may be NULL.
+ *
+ * \return Returns \c siap_error_server_overloaded if the queue is full or the request could not start before its deadline,
+ * \c siap_error_deadline_expired if the deadline has passed, or \c siap_error_invalid_input if the workers are not running;
+ * the callback is only called if the request was queued.
+ */
+SIAP_EXPORT_API siap_errors siap_server_authenticate_async(siap_server_context* ctx, siap_server_request* request, siap_server_callback callback, void* user);
+
+/**
+ * \brief Authenticate a batch of devices on the context workers.
+ * The batch is split into stripes; the calling thread runs the first, and the others are queued for the workers started
+ * with \c siap_server_context_start, which run them in their own workspaces. No thread is created by the call.
+ * When the calling thread finishes its stripe, any stripe still waiting in the queue is withdrawn and run by the calling thread,
+ * and the call returns once the stripes taken by workers are complete. If the workers are not running, the calling thread runs the whole batch.
+ * Each item is authenticated as by \c siap_server_context_authenticate_device,
+ * and its result is written to the errors array; a failed item does not stop the batch.
+ *
+ * \param ctx A pointer to the server context.
+ * \param dtoks The output device token array of size \c count * SIAP_AUTHENTICATION_TOKEN_SIZE.
+ * \param dkeys The device key array.
+ * \param dtags The device tag array.
+ * \param phashes [const] The passphrase hash array of size \c count * SIAP_HASH_SIZE.
+ * \param errors The output array of per-item results.
+ * \param count The number of devices in the batch.
+ * \param threads The number of threads sharing the batch, the calling thread and up to one fewer context workers;
+ * zero uses every context worker. The count is limited by the running workers and the free queue entries.
+ * \param rate The output batch throughput in authentications per second, may be NULL.
+ *
+ * \return Returns the number of devices authenticated.
+ */
+SIAP_EXPORT_API size_t siap_server_authenticate_batch(siap_server_context* ctx, uint8_t* dtoks, siap_device_key* dkeys, siap_device_tag* dtags, const uint8_t* phashes, siap_errors* errors, size_t count, size_t threads, uint64_t* rate);
+
+/**
+ * \brief Get the time used by request deadlines.
+ * A deadline is set as this time plus the time allowed for the request.
+ *
+ * \return Returns the time in milliseconds.
+ */
+SIAP_EXPORT_API uint64_t siap_server_clock_ms(void);
+
+/**
+ * \brief Take a workspace from the context memory, and register it with the context.
+ * The workspace is taken from the context arena, or from the heap when the context has none, and is zeroed.
+ * A worker thread that keeps its own workspace for \c siap_server_context_authenticate_workspace takes it here.
+ *
+ * \param ctx A pointer to the server context.
+ *
+ * \return Returns the workspace, or NULL if the arena is exhausted or the memory could not be allocated.
+ */
+SIAP_EXPORT_API siap_server_workspace* siap_server_context_acquire_workspace(siap_server_context* ctx);
+
+/**
+ * \brief Add a server key to the context, or replace the key with the same server identity.
+ *
+ * \param ctx A pointer to the server context.
+ * \param skey [const] A pointer to the server key.
+ *
+ * \return Returns false if the key could not be prepared or the context key set is full.
+ */
+SIAP_EXPORT_API bool siap_server_context_add_key(siap_server_context* ctx, const siap_server_key* skey);
+
+/**
+ * \brief Authenticate a device with the server key selected by the device key identity.
+ * This function is equivalent to \c siap_server_authenticate_device.
+ *
+ * \param ctx A pointer to the server context.
+ * \param dtok The pointer to the output device token.
+ * \param dkey The pointer to the device key.
+ * \param dtag The pointer to the device tag.
+ * \param phash [const] The user passphrase hash.
+ *
+ * \return Returns \c siap_error_identity_mismatch if the context holds no key for the device's server identity.
+ */
+SIAP_EXPORT_API siap_errors siap_server_context_authenticate_device(siap_server_context* ctx, uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const uint8_t* phash);
+
+/**
+ * \brief Authenticate a device using a segmented device key, with the server key selected by the device key identity.
+ * This function is equivalent to \c siap_server_authenticate_segmented_key.
+ *
+ * \param ctx A pointer to the server context.
+ * \param dtok The pointer to the output device token.
+ * \param dkey The pointer to the segmented device key.
+ * \param dtag The pointer to the device tag.
+ * \param phash [const] The user passphrase hash.
+ *
+ * \return Returns \c siap_error_identity_mismatch if the context holds no key for the device's server identity.
+ */
+SIAP_EXPORT_API siap_errors siap_server_context_authenticate_segmented_key(siap_server_context* ctx, uint8_t* dtok, siap_segmented_key* dkey, siap_device_tag* dtag, const uint8_t* phash);
+
+/**
+ * \brief Authenticate a device using a variable-size device key, with the server key selected by the device key identity.
+ * This function is equivalent to \c siap_server_authenticate_variable_key.
+ *
+ * \param ctx A pointer to the server context.
+ * \param dtok The pointer to the output device token.
+ * \param vkey The pointer to the variable-size device key.
+ * \param dtag The pointer to the device tag.
+ * \param phash [const] The user passphrase hash.
+ *
+ * \return Returns \c siap_error_identity_mismatch if the context holds no key for the device's server identity.
+ */
+SIAP_EXPORT_API siap_errors siap_server_context_authenticate_variable_key(siap_server_context* ctx, uint8_t* dtok, siap_variable_key* vkey, siap_device_tag* dtag, const uint8_t* phash);
+
+/**
+ * \brief Authenticate a device using a caller workspace.
+ * This function is equivalent to \c siap_server_context_authenticate_device, but caches the prepared key in the
+ * caller's workspace instead of one from the context pool. A worker thread that keeps its own workspace never
+ * contends for the pool, and the workspace stays in the worker's memory.
+ * The workspace must not be used by two calls at once. A workspace that lives longer than one call should be taken with
+ * \c siap_server_context_acquire_workspace, or registered with \c siap_server_context_register_workspace, so a removed key
+ * is erased from it while it is idle.
+ *
+ * \param ctx A pointer to the server context.
+ * \param workspace A pointer to the caller workspace, cleared before its first use; NULL borrows one from the pool.
+ * \param dtok The pointer to the output device token.
+ * \param dkey The pointer to the device key.
+ * \param dtag The pointer to the device tag.
+ * \param phash [const] The user passphrase hash.
+ *
+ * \return Returns \c siap_error_identity_mismatch if the context holds no key for the device's server identity.
+ */
+SIAP_EXPORT_API siap_errors siap_server_context_authenticate_workspace(siap_server_context* ctx, siap_server_workspace* workspace, uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const uint8_t* phash);
+
+/**
+ * \brief Decrypt a device key with the server key selected by the device key identity.
+ *
+ * \param ctx A pointer to the server context.
+ * \param dkey The pointer to the device key.
+ * \param phash [const] The passphrase hash.
+ *
+ * \return Returns false if no key matches or the decryption failed.
+ */
+SIAP_EXPORT_API bool siap_server_context_decrypt_device_key(siap_server_context* ctx, siap_device_key* dkey, const uint8_t* phash);
+
+/**
+ * \brief Dispose of the server context, erasing the server keys and releasing the workspaces.
+ * The workers are stopped first, completing the queued requests. No other call may be in progress on the context.
+ *
+ * \param ctx A pointer to the server context.
+ */
+SIAP_EXPORT_API void siap_server_context_dispose(siap_server_context* ctx);
+
+/**
+ * \brief Encrypt a device key with the server key selected by the device key identity.
+ *
+ * \param ctx A pointer to the server context.
+ * \param dkey The pointer to the device key.
+ * \param phash [const] The passphrase hash.
+ *
+ * \return Returns false if the context holds no key for the device's server identity.
+ */
+SIAP_EXPORT_API bool siap_server_context_encrypt_device_key(siap_server_context* ctx, siap_device_key* dkey, const uint8_t* phash);
+
+/**
+ * \brief Generate the server authentication token for a device tag.
+ *
+ * \param ctx A pointer to the server context.
+ * \param token The output authentication token.
+ * \param dtag [const] A pointer to the device tag.
+ *
+ * \return Returns false if no key matches or the token could not be generated.
+ */
+SIAP_EXPORT_API bool siap_server_context_generate_authentication_token(siap_server_context* ctx, uint8_t* token, const siap_device_tag* dtag);
+
+/**
+ * \brief Generate a device key with the server key selected by the device identity.
+ *
+ * \param ctx A pointer to the server context.
+ * \param dkey A pointer to the SIAP device key structure.
+ * \param did [const] The device identity array.
+ *
+ * \return Returns false if the context holds no key for the device's server identity.
+ */
+SIAP_EXPORT_API bool siap_server_context_generate_device_key(siap_server_context* ctx, siap_device_key* dkey, const uint8_t* did);
+
+/**
+ * \brief Initialize a server context.
+ * The prepared keys and the workspaces are allocated on the heap.
+ *
+ * \param ctx A pointer to the server context.
+ * \param workspaces The number of workspaces, usually the number of threads calling into the context;
+ * zero selects the processor count. The count is limited to \c SIAP_SERVER_CONTEXT_WORKSPACES_MAX.
+ *
+ * \return Returns false if the multi-buffer Keccak self-test fails, or the workspaces or the mutex could not be allocated.
+ */
+SIAP_EXPORT_API bool siap_server_context_initialize(siap_server_context* ctx, size_t workspaces);
+
+/**
+ * \brief Initialize a server context that takes its key material from a secure arena.
+ * Each prepared key, each pooled workspace, and each worker workspace is one arena slot, so the slot size must be at
+ * least the size of \c siap_server_workspace, and the arena needs a slot for every workspace, every worker,
+ * and every server key, with a spare slot for each call made while every workspace is busy.
+ * The arena is not owned by the context, and must be disposed after the context.
+ *
+ * \param ctx A pointer to the server context.
+ * \param workspaces The number of workspaces, see \c siap_server_context_initialize.
+ * \param arena A pointer to an initialized arena, NULL allocates on the heap.
+ *
+ * \return Returns false if the arena slots are too small or too few, or the context could not be initialized.
+ */
+SIAP_EXPORT_API bool siap_server_context_initialize_arena(siap_server_context* ctx, size_t workspaces, siap_secure_arena* arena);
+
+/**
+ * \brief Issue a session ticket with the server key selected by the device tag identity.
+ * This function is equivalent to \c siap_server_issue_ticket.
+ *
+ * \param ctx A pointer to the server context.
+ * \param ticket A pointer to the output session ticket.
+ * \param dtok [const] The device token returned by the authentication.
+ * \param dtag [const] The device tag, as updated by the authentication.
+ * \param lifetime The ticket lifetime in seconds.
+ *
+ * \return Returns false if no key matches or the ticket could not be issued.
+ */
+SIAP_EXPORT_API bool siap_server_context_issue_ticket(siap_server_context* ctx, siap_session_ticket* ticket, const uint8_t* dtok, const siap_device_tag* dtag, uint32_t lifetime);
+
+/**
+ * \brief Register a caller workspace with the context.
+ * A registered workspace is treated as the pool workspaces are when a key is removed: if it is idle, its cached copy of
+ * the removed key is erased at once, and if it is in use, when its call completes. A workspace taken with
+ * \c siap_server_context_acquire_workspace, as the context and executor workers take theirs, is already registered.
+ *
+ * \param ctx A pointer to the server context.
+ * \param workspace A pointer to the caller workspace, cleared before it is registered.
+ *
+ * \return Returns false if the context is not initialized.
+ */
+SIAP_EXPORT_API bool siap_server_context_register_workspace(siap_server_context* ctx, siap_server_workspace* workspace);
+
+/**
+ * \brief Unregister a workspace taken with \c siap_server_context_acquire_workspace, erase it, and return it to the context memory.
+ * The workspace must not be in use.
+ *
+ * \param ctx A pointer to the server context.
+ * \param workspace A pointer to the workspace, may be NULL.
+ */
+SIAP_EXPORT_API void siap_server_context_release_workspace(siap_server_context* ctx, siap_server_workspace* workspace);
+
+/**
+ * \brief Remove a server key from the context, erasing the prepared key.
+ * The cached copies in the idle pool and registered workspaces are erased; a workspace in use erases its copy when its call completes.
+ *
+ * \param ctx A pointer to the server context.
+ * \param sid [const] The server identity array of size \c SIAP_SID_SIZE.
+ *
+ * \return Returns false if the context holds no key with this server identity.
+ */
+SIAP_EXPORT_API bool siap_server_context_remove_key(siap_server_context* ctx, const uint8_t* sid);
+
+/**
+ * \brief Screen a device with the server key selected by the device key identity.
+ * This function is equivalent to \c siap_server_screen_device.
+ *
+ * \param ctx A pointer to the server context.
+ * \param dkey [const] The pointer to the device key.
+ * \param dtag [const] The pointer to the device tag.
+ *
+ * \return Returns \c siap_error_identity_mismatch if the context holds no key for the device's server identity.
+ */
+SIAP_EXPORT_API siap_errors siap_server_context_screen_device(siap_server_context* ctx, const siap_device_key* dkey, const siap_device_tag* dtag);
+
+/**
+ * \brief Screen a device using a caller workspace.
+ * This function is equivalent to \c siap_server_context_screen_device, see \c siap_server_context_authenticate_workspace.
+ *
+ * \param ctx A pointer to the server context.
+ * \param workspace A pointer to the caller workspace; NULL borrows one from the pool.
+ * \param dkey [const] The pointer to the device key.
+ * \param dtag [const] The pointer to the device tag.
+ *
+ * \return Returns \c siap_error_identity_mismatch if the context holds no key for the device's server identity.
+ */
+SIAP_EXPORT_API siap_errors siap_server_context_screen_workspace(siap_server_context* ctx, siap_server_workspace* workspace, const siap_device_key* dkey, const siap_device_tag* dtag);
+
+/**
+ * \brief Start the asynchronous authentication workers.
+ * Each worker allocates its own workspace; a pinned worker does so after it is pinned, so its workspace,
+ * and the SCB memory it allocates while hashing, are on its own NUMA node.
+ *
+ * \param ctx A pointer to the server context.
+ * \param threads The number of worker threads, zero uses one per context workspace.
+ * The count is limited to \c SIAP_SERVER_BATCH_THREADS_MAX.
+ * \param pinned Pin each worker to its own processor, see \c siap_affinity_worker_processor.
+ *
+ * \return Returns false if the workers are already running, the queue could not be allocated, or no worker could be started.
+ * When only some of the workers start, the context runs with those.
+ */
+SIAP_EXPORT_API bool siap_server_context_start(siap_server_context* ctx, size_t threads, bool pinned);
+
+/**
+ * \brief Stop the asynchronous authentication workers.
+ * New requests are refused at once; the call returns when the queued requests have completed and the workers have exited.
+ * Must not be called from a completion callback.
+ *
+ * \param ctx A pointer to the server context.
+ */
+SIAP_EXPORT_API void siap_server_context_stop(siap_server_context* ctx);
+
+/**
+ * \brief Unregister a caller workspace from the context, and erase its cached key.
+ * The workspace must not be in use, and must be unregistered before it is released.
+ *
+ * \param ctx A pointer to the server context.
+ * \param workspace A pointer to the registered caller workspace.
+ */
+SIAP_EXPORT_API void siap_server_context_unregister_workspace(siap_server_context* ctx, siap_server_workspace* workspace);
+
+/**
+ * \brief Verify a session ticket with the server key selected by the ticket identity.
+ * This function is equivalent to \c siap_server_verify_ticket.
+ *
+ * \param ctx A pointer to the server context.
+ * \param ticket [const] A pointer to the session ticket.
+ * \param dtag [const] The current device tag.
+ *
+ * \return Returns \c siap_error_identity_mismatch if the context holds no key for the ticket's server identity.
+ */
+SIAP_EXPORT_API siap_errors siap_server_context_verify_ticket(siap_server_context* ctx, const siap_session_ticket* ticket, const siap_device_tag* dtag);
+
+#endif
@@ -0,0 +1,370 @@
+#include "executor.h"
+#include "affinity.h"
+#include "intutils.h"
+#include "memutils.h"
+
+static bool executor_deque_push(siap_executor_deque* deque, const siap_executor_task* task)
+{
+	bool res;
+
+	res = false;
+	qsc_async_mutex_lock(deque->mutex);
+
+	if (deque->count < SIAP_EXECUTOR_DEQUE_DEPTH)
+	{
+		deque->tasks[(deque->head + deque->count) % SIAP_EXECUTOR_DEQUE_DEPTH] = *task;
+		++deque->count;
+		res = true;
+	}
+
+	qsc_async_mutex_unlock(deque->mutex);
+
+	return res;
+}
+
+static bool executor_deque_take(siap_executor_deque* deque, siap_executor_task* task, bool owner)
+{
+	size_t tidx;
+	bool res;
+
+	res = false;
+	qsc_async_mutex_lock(deque->mutex);
+
+	if (deque->count != 0U)
+	{
+		tidx = (deque->head + deque->count - 1U) % SIAP_EXECUTOR_DEQUE_DEPTH;
+
+		/* the owner takes its newest task only when it is a successor stage it queued itself, so a request it
+		   advanced completes first; new screen tasks are submitted round robin and are always taken oldest first */
+		if (owner == true && deque->tasks[tidx].stage != siap_executor_stage_screen)
+		{
+			*task = deque->tasks[tidx];
+		}
+		else
+		{
+			*task = deque->tasks[deque->head];
+			deque->head = (deque->head + 1U) % SIAP_EXECUTOR_DEQUE_DEPTH;
+		}
+
+		--deque->count;
+		res = true;
+	}
+
+	qsc_async_mutex_unlock(deque->mutex);
+
+	return res;
+}
+
+static bool executor_find(siap_executor_worker* worker, siap_executor_task* task)
+{
+	siap_server_executor* exec;
+	size_t widx;
+	bool res;
+
+	exec = worker->executor;
+
+	/* light work first, the worker's own successors, then the oldest screens, then the oldest of every other worker's */
+	res = executor_deque_take(&worker->light, task, true);
+
+	for (size_t i = 1U; res == false && i < exec->wcount; ++i)
+	{
+		widx = (worker->index + i) % exec->wcount;
+		res = executor_deque_take(&exec->workers[widx].light, task, false);
+	}
+
+	/* then the hashes, oldest first so no request waits behind newer ones */
+	if (res == false)
+	{
+		res = executor_deque_take(&worker->heavy, task, false);
+	}
+
+	for (size_t i = 1U; res == false && i < exec->wcount; ++i)
+	{
+		widx = (worker->index + i) % exec->wcount;
+		res = executor_deque_take(&exec->workers[widx].heavy, task, false);
+	}
+
+	return res;
+}
+
+static void executor_complete(siap_server_executor* exec, siap_executor_task* task, siap_errors err)
+{
+	qsc_memutils_secure_erase(task->request->phash, SIAP_HASH_SIZE);
+	task->callback(task->request, err, task->user);
+
+	qsc_async_mutex_lock(exec->mutex);
+	--exec->pending;
+	qsc_async_mutex_unlock(exec->mutex);
+}
+
+static void executor_run(siap_executor_worker* worker, siap_executor_task* task)
+{
+	siap_server_executor* exec;
+	siap_server_staged_request* req;
+	siap_errors err;
+	bool done;
+	bool res;
+
+	exec = worker->executor;
+	req = task->request;
+	err = siap_error_none;
+	done = false;
+
+	/* a stage whose successor cannot be queued runs the successor at once */
+	while (done == false)
+	{
+		if (req->deadline != 0U && siap_server_clock_ms() > req->deadline)
+		{
+			/* a late request is dropped before the hash or the key decryption is paid for */
+			err = siap_error_deadline_expired;
+			done = true;
+		}
+		else if (task->stage == siap_executor_stage_screen)
+		{
+			/* reject a mismatched or expired key before the passphrase hash is paid for */
+			err = siap_server_context_screen_workspace(exec->ctx, worker->workspace, req->dkey, req->dtag);
+			task->stage = (req->passphrase != NULL) ? siap_executor_stage_hash : siap_executor_stage_authenticate;
+			done = (err != siap_error_none);
+		}
+		else if (task->stage == siap_executor_stage_hash)
+		{
+			task->stage = siap_executor_stage_authenticate;
+
+			/* the worker runs the SCB state in its own workspace, QSC still allocates the memory-hard cache per hash */
+			if (worker->workspace != NULL)
+			{
+				res = siap_server_passphrase_hash_generate_scratch(req->phash, req->passphrase, req->passlen, req->dtag->cpucost, req->dtag->memcost, &worker->workspace->scratch);
+			}
+			else
+			{
+				res = siap_server_passphrase_hash_generate_costs(req->phash, req->passphrase, req->passlen, req->dtag->cpucost, req->dtag->memcost);
+			}
+
+			if (res == false)
+			{
+				err = siap_error_invalid_input;
+				done = true;
+			}
+		}
+		else
+		{
+			err = siap_server_context_authenticate_workspace(exec->ctx, worker->workspace, req->dtok, req->dkey, req->dtag, req->phash);
+			done = true;
+		}
+
+		if (done == false)
+		{
+			done = executor_deque_push((task->stage == siap_executor_stage_hash) ? &worker->heavy : &worker->light, task);
+
+			/* the successor was queued, it completes the request */
+			if (done == true)
+			{
+				task = NULL;
+			}
+		}
+	}
+
+	if (task != NULL)
+	{
+		executor_complete(exec, task, err);
+	}
+}
+
+static void executor_worker(void* state)
+{
+	siap_executor_worker* worker;
+	siap_executor_task task = { 0 };
+	bool active;
+
+	worker = (siap_executor_worker*)state;
+	active = true;
+
+	if (worker->executor->pinned == true)
+	{
+		(void)siap_affinity_pin_thread(siap_affinity_worker_processor(worker->index));
+	}
+
+	/* the workspace is taken on the worker's own thread after it is pinned, so a heap workspace is node-local;
+	   if it cannot be taken the worker borrows from the context pool */
+	worker->workspace = siap_server_context_acquire_workspace(worker->executor->ctx);
+
+	while (active == true)
+	{
+		if (executor_find(worker, &task) == true)
+		{
+			executor_run(worker, &task);
+		}
+		else
+		{
+			/* a stopped executor is drained before the workers exit */
+			qsc_async_mutex_lock(worker->executor->mutex);
+			active = (worker->executor->running == true || worker->executor->pending != 0U);
+			qsc_async_mutex_unlock(worker->executor->mutex);
+
+			if (active == true)
+			{
+				qsc_async_thread_sleep(SIAP_SERVER_WORKER_IDLE_MS);
+			}
+		}
+	}
+
+	siap_server_context_release_workspace(worker->executor->ctx, worker->workspace);
+	worker->workspace = NULL;
+}
+
+void siap_server_executor_dispose(siap_server_executor* exec)
+{
+	if (exec != NULL)
+	{
+		if (exec->mutex != NULL)
+		{
+			qsc_async_mutex_lock(exec->mutex);
+			exec->running = false;
+			qsc_async_mutex_unlock(exec->mutex);
+		}
+
+		if (exec->workers != NULL)
+		{
+			for (size_t i = 0U; i < exec->wcount; ++i)
+			{
+				if (exec->workers[i].started == true)
+				{
+					qsc_async_thread_wait(exec->workers[i].thread);
+				}
+			}
+
+			for (size_t i = 0U; i < exec->wcount; ++i)
+			{
+				if (exec->workers[i].light.mutex != NULL)
+				{
+					qsc_async_mutex_destroy(exec->workers[i].light.mutex);
+				}
+
+				if (exec->workers[i].heavy.mutex != NULL)
+				{
+					qsc_async_mutex_destroy(exec->workers[i].heavy.mutex);
+				}
+			}
+
+			qsc_memutils_alloc_free(exec->workers);
+			exec->workers = NULL;
+		}
+
+		if (exec->mutex != NULL)
+		{
+			qsc_async_mutex_destroy(exec->mutex);
+			exec->mutex = NULL;
+		}
+
+		exec->ctx = NULL;
+		exec->wcount = 0U;
+		exec->next = 0U;
+		exec->pending = 0U;
+	}
+}
+
+bool siap_server_executor_initialize(siap_server_executor* exec, siap_server_context* ctx, size_t threads, bool pinned)
+{
+	SIAP_ASSERT(exec != NULL);
+	SIAP_ASSERT(ctx != NULL);
+
+	size_t wlen;
+	bool res;
+
+	res = false;
+
+	if (exec != NULL && ctx != NULL)
+	{
+		qsc_memutils_clear(exec, sizeof(siap_server_executor));
+		exec->ctx = ctx;
+		exec->pinned = pinned;
+		exec->wcount = (threads != 0U) ? threads : qsc_async_processor_count();
+		exec->wcount = qsc_intutils_min(qsc_intutils_max(exec->wcount, 1U), SIAP_SERVER_BATCH_THREADS_MAX);
+		exec->mutex = qsc_async_mutex_create();
+		wlen = exec->wcount * sizeof(siap_executor_worker);
+		exec->workers = (siap_executor_worker*)qsc_memutils_malloc(wlen);
+		res = (exec->mutex != NULL && exec->workers != NULL);
+
+		if (res == true)
+		{
+			qsc_memutils_clear(exec->workers, wlen);
+
+			for (size_t i = 0U; i < exec->wcount; ++i)
+			{
+				exec->workers[i].executor = exec;
+				exec->workers[i].index = i;
+				exec->workers[i].light.mutex = qsc_async_mutex_create();
+				exec->workers[i].heavy.mutex = qsc_async_mutex_create();
+				res = (res == true && exec->workers[i].light.mutex != NULL && exec->workers[i].heavy.mutex != NULL);
+			}
+		}
+
+		if (res == true)
+		{
+			/* every deque exists before the first worker can steal from it */
+			exec->running = true;
+
+			for (size_t i = 0U; res == true && i < exec->wcount; ++i)
+			{
+				exec->workers[i].started = siap_affinity_thread_create(&exec->workers[i].thread, &executor_worker, &exec->workers[i]);
+				res = exec->workers[i].started;
+			}
+		}
+
+		if (res == false)
+		{
+			/* the workers that did start are stopped and waited on */
+			siap_server_executor_dispose(exec);
+		}
+	}
+
+	return res;
+}
+
+siap_errors siap_server_executor_submit(siap_server_executor* exec, siap_server_staged_request* request, siap_server_staged_callback callback, void* user)
+{
+	SIAP_ASSERT(exec != NULL);
+	SIAP_ASSERT(request != NULL);
+	SIAP_ASSERT(callback != NULL);
+
+	siap_executor_task task = { 0 };
+	siap_errors err;
+	size_t first;
+	bool res;
+
+	err = siap_error_invalid_input;
+	res = false;
+
+	if (exec != NULL && exec->mutex != NULL && request != NULL && request->dkey != NULL && request->dtag != NULL && callback != NULL)
+	{
+		task.request = request;
+		task.callback = callback;
+		task.user = user;
+		task.stage = siap_executor_stage_screen;
+
+		qsc_async_mutex_lock(exec->mutex);
+
+		if (exec->running == true && request->deadline != 0U && siap_server_clock_ms() > request->deadline)
+		{
+			err = siap_error_deadline_expired;
+		}
+		else if (exec->running == true)
+		{
+			/* requests are spread round robin, skipping workers whose light deque is full */
+			first = exec->next;
+			exec->next = (exec->next + 1U) % exec->wcount;
+
+			for (size_t i = 0U; res == false && i < exec->wcount; ++i)
+			{
+				res = executor_deque_push(&exec->workers[(first + i) % exec->wcount].light, &task);
+			}
+
+			exec->pending += (res == true) ? 1U : 0U;
+			err = (res == true) ? siap_error_none : siap_error_server_overloaded;
+		}
+
+		qsc_async_mutex_unlock(exec->mutex);
+	}
+
+	return err;
+}
@@ -0,0 +1,208 @@
+/* 2025-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SIAP_EXECUTOR_H
+#define SIAP_EXECUTOR_H
+
+#include "siapcommon.h"
+#include "context.h"
+
+/**
+* \file executor.h
+* \brief SIAP staged authentication executor.
+*
+* \details
+* The executor splits a passphrase authentication into three stages: a screen of the key identity and expiration,
+* the memory-hard SCB passphrase hash, and the key tree authentication. Each worker owns two deques, a light deque
+* for the screen and authentication stages and a heavy deque for the passphrase hash. A worker runs light tasks first,
+* its own and then those it steals from other workers, and only takes a hash task when no light task is waiting,
+* so screens reject failing requests and finished hashes complete while other workers keep every core busy hashing.
+*
+* A worker pushes the next stage of a request onto its own deque and runs that successor first, but takes the screen
+* tasks submitted to it oldest first, so a steady flow of new requests cannot starve the ones already waiting.
+* An idle worker steals the oldest task from the other workers, light tasks before heavy tasks.
+*/
+
+/*!
+* \def SIAP_EXECUTOR_DEQUE_DEPTH
+* \brief The number of tasks each worker deque can hold.
+*/
+#define SIAP_EXECUTOR_DEQUE_DEPTH 256U
+
+/*!
+ * \enum siap_executor_stages
+ * \brief The stages of a staged authentication.
+ */
+SIAP_EXPORT_API typedef enum siap_executor_stages
+{
+	siap_executor_stage_screen = 0x00U,			/*!< The key identity and expiration checks */
+	siap_executor_stage_hash = 0x01U,			/*!< The SCB passphrase hash */
+	siap_executor_stage_authenticate = 0x02U	/*!< The key tree decryption and token checks */
+} siap_executor_stages;
+
+/*!
+ * \struct siap_server_staged_request
+ * \brief A staged authentication request.
+ * The request, and the key and tag it points to, must remain valid until its callback has been called.
+ */
+SIAP_EXPORT_API typedef struct siap_server_staged_request
+{
+	uint8_t dtok[SIAP_AUTHENTICATION_TOKEN_SIZE];	/*!< The output device token */
+	uint8_t phash[SIAP_HASH_SIZE];				/*!< The passphrase hash, computed by the hash stage when a passphrase is set, erased on completion */
+	siap_device_key* dkey;						/*!< The device key */
+	siap_device_tag* dtag;						/*!< The device tag */
+	const char* passphrase;						/*!< The passphrase, or NULL to skip the hash stage and use the phash member */
+	size_t passlen;								/*!< The passphrase length */
+	uint64_t deadline;							/*!< The time by which each stage must start, see \c siap_server_clock_ms, zero for none */
+} siap_server_staged_request;
+
+/*!
+ * \brief The staged authentication completion callback.
+ * Called on an executor worker thread with the request, the result, and the caller's user pointer.
+ * A request whose deadline passes before its passphrase hash or authentication stage starts is completed with
+ * \c siap_error_deadline_expired, and that stage is not run.
+ */
+typedef void (*siap_server_staged_callback)(siap_server_staged_request* request, siap_errors error, void* user);
+
+/*!
+ * \struct siap_executor_task
+ * \brief A staged authentication waiting for its next stage.
+ */
+SIAP_EXPORT_API typedef struct siap_executor_task
+{
+	siap_server_staged_request* request;		/*!< The request */
+	siap_server_staged_callback callback;		/*!< The completion callback */
+	void* user;									/*!< The caller's user pointer */
+	siap_executor_stages stage;					/*!< The next stage to run */
+} siap_executor_task;
+
+/*!
+ * \struct siap_executor_deque
+ * \brief A worker task deque; the owner takes its own queued successors from the tail and screens from the head, thieves take from the head.
+ */
+SIAP_EXPORT_API typedef struct siap_executor_deque
+{
+	siap_executor_task tasks[SIAP_EXECUTOR_DEQUE_DEPTH];	/*!< The task ring */
+	size_t head;								/*!< The ring index of the oldest task */
+	size_t count;								/*!< The number of tasks */
+	qsc_mutex mutex;							/*!< The deque mutex */
+} siap_executor_deque;
+
+/*!
+ * \struct siap_executor_worker
+ * \brief An executor worker.
+ */
+SIAP_EXPORT_API typedef struct siap_executor_worker
+{
+	siap_executor_deque light;					/*!< The screen and authentication tasks */
+	siap_executor_deque heavy;					/*!< The passphrase hash tasks */
+	struct siap_server_executor* executor;		/*!< The owning executor */
+	siap_server_workspace* workspace;			/*!< The worker's own workspace, allocated by the worker thread */
+	size_t index;								/*!< The worker index */
+	qsc_thread thread;							/*!< The worker thread */
+	bool started;								/*!< The worker thread was started */
+} siap_executor_worker;
+
+/*!
+ * \struct siap_server_executor
+ * \brief The SIAP staged authentication executor.
+ */
+SIAP_EXPORT_API typedef struct siap_server_executor
+{
+	siap_server_context* ctx;					/*!< The server context the requests are authenticated with */
+	siap_executor_worker* workers;				/*!< The workers */
+	size_t wcount;								/*!< The number of workers */
+	size_t next;								/*!< The worker the next request is submitted to */
+	size_t pending;								/*!< The number of requests not yet completed */
+	qsc_mutex mutex;							/*!< The submission and shutdown mutex */
+	bool pinned;								/*!< The workers are pinned to processors */
+	bool running;								/*!< The executor is accepting requests */
+} siap_server_executor;
+
+/**
+ * \brief Stop the executor and release its workers.
+ * New requests are refused at once; the call returns when the submitted requests have completed.
+ * Must not be called from a completion callback.
+ *
+ * \param exec A pointer to the executor.
+ */
+SIAP_EXPORT_API void siap_server_executor_dispose(siap_server_executor* exec);
+
+/**
+ * \brief Initialize an executor and start its workers.
+ * Each worker allocates its own workspace; a pinned worker does so after it is pinned, so its workspace,
+ * and the SCB memory it allocates while hashing, are on its own NUMA node.
+ *
+ * \param exec A pointer to the executor.
+ * \param ctx A pointer to an initialized server context; it must outlive the executor.
+ * \param threads The number of workers, zero selects the processor count.
+ * The count is limited to \c SIAP_SERVER_BATCH_THREADS_MAX.
+ * \param pinned Pin each worker to its own processor, see \c siap_affinity_worker_processor.
+ *
+ * \return Returns false if the workers could not be allocated or started; the executor is disposed.
+ */
+SIAP_EXPORT_API bool siap_server_executor_initialize(siap_server_executor* exec, siap_server_context* ctx, size_t threads, bool pinned);
+
+/**
+ * \brief Submit a staged authentication.
+ * The callback is called on a worker thread when the request completes or is rejected by a stage.
+ *
+ * \param exec A pointer to the executor.
+ * \param request A pointer to the request.
+ * \param callback The completion callback.
+ * \param user A caller pointer passed to the callback, may be NULL.
+ *
+ * \return Returns \c siap_error_server_overloaded if every worker deque is full, \c siap_error_deadline_expired if the deadline
+ * has passed, or \c siap_error_invalid_input if the executor is stopped; the callback is only called if the request was accepted.
+ */
+SIAP_EXPORT_API siap_errors siap_server_executor_submit(siap_server_executor* exec, siap_server_staged_request* request, siap_server_staged_callback callback, void* user);
+
+#endif
@@ -0,0 +1,742 @@
+#include "keccakx.h"
+#include "intrinsics.h"
+#include "intutils.h"
+#include "memutils.h"
+
+#if defined(QSC_SYSTEM_HAS_AVX512)
+#	define KECCAKX_HAS_X8
+#endif
+#if defined(QSC_SYSTEM_HAS_AVX2)
+#	define KECCAKX_HAS_X4
+#endif
+
+/* GCC and Clang x86 builds compile the vector kernels the build flags do not enable for their own
+   instruction set, and select them at runtime if the processor supports it */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#	include <immintrin.h>
+#	if !defined(KECCAKX_HAS_X8)
+#		define KECCAKX_HAS_X8
+#		define KECCAKX_DISPATCH_X8
+#		define KECCAKX_TARGET_X8 __attribute__((target("avx512f")))
+#	endif
+#	if !defined(KECCAKX_HAS_X4)
+#		define KECCAKX_HAS_X4
+#		define KECCAKX_DISPATCH_X4
+#		define KECCAKX_TARGET_X4 __attribute__((target("avx2")))
+#	endif
+#endif
+#if !defined(KECCAKX_TARGET_X8)
+#	define KECCAKX_TARGET_X8
+#endif
+#if !defined(KECCAKX_TARGET_X4)
+#	define KECCAKX_TARGET_X4
+#endif
+
+/* the self-test message count covers one 8 lane sweep, one 4 lane sweep and the scalar tail */
+#define KECCAKX_SELF_TEST_LANES 13U
+#define KECCAKX_SELF_TEST_CUSTOM 16U
+#define KECCAKX_SELF_TEST_KEY 200U
+#define KECCAKX_SELF_TEST_OUTPUT 160U
+
+#if defined(KECCAKX_HAS_X4) || defined(KECCAKX_HAS_X8)
+static const uint64_t KECCAKX_ROUND_CONSTANTS[QSC_KECCAK_PERMUTATION_ROUNDS] =
+{
+	0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+	0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+	0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+	0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+	0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+	0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+#endif
+
+#if defined(KECCAKX_HAS_X4)
+#	define KECCAKX_ROL256(x, n) _mm256_or_si256(_mm256_slli_epi64((x), (n)), _mm256_srli_epi64((x), 64 - (n)))
+
+static KECCAKX_TARGET_X4 void keccakx_permute_x4(uint64_t* state)
+{
+	/* the state is interleaved; word i of lane j is at state[(i * SIAP_KECCAKX_LANES_MAX) + j] */
+	__m256i a[QSC_KECCAK_STATE_SIZE];
+	__m256i b[QSC_KECCAK_STATE_SIZE];
+	__m256i c0;
+	__m256i c1;
+	__m256i c2;
+	__m256i c3;
+	__m256i c4;
+	__m256i d0;
+	__m256i d1;
+	__m256i d2;
+	__m256i d3;
+	__m256i d4;
+
+	for (size_t i = 0U; i < QSC_KECCAK_STATE_SIZE; ++i)
+	{
+		a[i] = _mm256_loadu_si256((const __m256i*)(state + (i * SIAP_KECCAKX_LANES_MAX)));
+	}
+
+	for (size_t r = 0U; r < QSC_KECCAK_PERMUTATION_ROUNDS; ++r)
+	{
+		c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[0], a[5]), _mm256_xor_si256(a[10], a[15])), a[20]);
+		c1 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[1], a[6]), _mm256_xor_si256(a[11], a[16])), a[21]);
+		c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[2], a[7]), _mm256_xor_si256(a[12], a[17])), a[22]);
+		c3 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[3], a[8]), _mm256_xor_si256(a[13], a[18])), a[23]);
+		c4 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[4], a[9]), _mm256_xor_si256(a[14], a[19])), a[24]);
+		d0 = _mm256_xor_si256(c4, KECCAKX_ROL256(c1, 1));
+		d1 = _mm256_xor_si256(c0, KECCAKX_ROL256(c2, 1));
+		d2 = _mm256_xor_si256(c1, KECCAKX_ROL256(c3, 1));
+		d3 = _mm256_xor_si256(c2, KECCAKX_ROL256(c4, 1));
+		d4 = _mm256_xor_si256(c3, KECCAKX_ROL256(c0, 1));
+		b[0] = _mm256_xor_si256(a[0], d0);
+		b[16] = KECCAKX_ROL256(_mm256_xor_si256(a[5], d0), 36);
+		b[7] = KECCAKX_ROL256(_mm256_xor_si256(a[10], d0), 3);
+		b[23] = KECCAKX_ROL256(_mm256_xor_si256(a[15], d0), 41);
+		b[14] = KECCAKX_ROL256(_mm256_xor_si256(a[20], d0), 18);
+		b[10] = KECCAKX_ROL256(_mm256_xor_si256(a[1], d1), 1);
+		b[1] = KECCAKX_ROL256(_mm256_xor_si256(a[6], d1), 44);
+		b[17] = KECCAKX_ROL256(_mm256_xor_si256(a[11], d1), 10);
+		b[8] = KECCAKX_ROL256(_mm256_xor_si256(a[16], d1), 45);
+		b[24] = KECCAKX_ROL256(_mm256_xor_si256(a[21], d1), 2);
+		b[20] = KECCAKX_ROL256(_mm256_xor_si256(a[2], d2), 62);
+		b[11] = KECCAKX_ROL256(_mm256_xor_si256(a[7], d2), 6);
+		b[2] = KECCAKX_ROL256(_mm256_xor_si256(a[12], d2), 43);
+		b[18] = KECCAKX_ROL256(_mm256_xor_si256(a[17], d2), 15);
+		b[9] = KECCAKX_ROL256(_mm256_xor_si256(a[22], d2), 61);
+		b[5] = KECCAKX_ROL256(_mm256_xor_si256(a[3], d3), 28);
+		b[21] = KECCAKX_ROL256(_mm256_xor_si256(a[8], d3), 55);
+		b[12] = KECCAKX_ROL256(_mm256_xor_si256(a[13], d3), 25);
+		b[3] = KECCAKX_ROL256(_mm256_xor_si256(a[18], d3), 21);
+		b[19] = KECCAKX_ROL256(_mm256_xor_si256(a[23], d3), 56);
+		b[15] = KECCAKX_ROL256(_mm256_xor_si256(a[4], d4), 27);
+		b[6] = KECCAKX_ROL256(_mm256_xor_si256(a[9], d4), 20);
+		b[22] = KECCAKX_ROL256(_mm256_xor_si256(a[14], d4), 39);
+		b[13] = KECCAKX_ROL256(_mm256_xor_si256(a[19], d4), 8);
+		b[4] = KECCAKX_ROL256(_mm256_xor_si256(a[24], d4), 14);
+		a[0] = _mm256_xor_si256(b[0], _mm256_andnot_si256(b[1], b[2]));
+		a[1] = _mm256_xor_si256(b[1], _mm256_andnot_si256(b[2], b[3]));
+		a[2] = _mm256_xor_si256(b[2], _mm256_andnot_si256(b[3], b[4]));
+		a[3] = _mm256_xor_si256(b[3], _mm256_andnot_si256(b[4], b[0]));
+		a[4] = _mm256_xor_si256(b[4], _mm256_andnot_si256(b[0], b[1]));
+		a[5] = _mm256_xor_si256(b[5], _mm256_andnot_si256(b[6], b[7]));
+		a[6] = _mm256_xor_si256(b[6], _mm256_andnot_si256(b[7], b[8]));
+		a[7] = _mm256_xor_si256(b[7], _mm256_andnot_si256(b[8], b[9]));
+		a[8] = _mm256_xor_si256(b[8], _mm256_andnot_si256(b[9], b[5]));
+		a[9] = _mm256_xor_si256(b[9], _mm256_andnot_si256(b[5], b[6]));
+		a[10] = _mm256_xor_si256(b[10], _mm256_andnot_si256(b[11], b[12]));
+		a[11] = _mm256_xor_si256(b[11], _mm256_andnot_si256(b[12], b[13]));
+		a[12] = _mm256_xor_si256(b[12], _mm256_andnot_si256(b[13], b[14]));
+		a[13] = _mm256_xor_si256(b[13], _mm256_andnot_si256(b[14], b[10]));
+		a[14] = _mm256_xor_si256(b[14], _mm256_andnot_si256(b[10], b[11]));
+		a[15] = _mm256_xor_si256(b[15], _mm256_andnot_si256(b[16], b[17]));
+		a[16] = _mm256_xor_si256(b[16], _mm256_andnot_si256(b[17], b[18]));
+		a[17] = _mm256_xor_si256(b[17], _mm256_andnot_si256(b[18], b[19]));
+		a[18] = _mm256_xor_si256(b[18], _mm256_andnot_si256(b[19], b[15]));
+		a[19] = _mm256_xor_si256(b[19], _mm256_andnot_si256(b[15], b[16]));
+		a[20] = _mm256_xor_si256(b[20], _mm256_andnot_si256(b[21], b[22]));
+		a[21] = _mm256_xor_si256(b[21], _mm256_andnot_si256(b[22], b[23]));
+		a[22] = _mm256_xor_si256(b[22], _mm256_andnot_si256(b[23], b[24]));
+		a[23] = _mm256_xor_si256(b[23], _mm256_andnot_si256(b[24], b[20]));
+		a[24] = _mm256_xor_si256(b[24], _mm256_andnot_si256(b[20], b[21]));
+		a[0] = _mm256_xor_si256(a[0], _mm256_set1_epi64x((int64_t)KECCAKX_ROUND_CONSTANTS[r]));
+	}
+
+	for (size_t i = 0U; i < QSC_KECCAK_STATE_SIZE; ++i)
+	{
+		_mm256_storeu_si256((__m256i*)(state + (i * SIAP_KECCAKX_LANES_MAX)), a[i]);
+	}
+}
+#endif
+
+#if defined(KECCAKX_HAS_X8)
+static KECCAKX_TARGET_X8 void keccakx_permute_x8(uint64_t* state)
+{
+	__m512i a[QSC_KECCAK_STATE_SIZE];
+	__m512i b[QSC_KECCAK_STATE_SIZE];
+	__m512i c0;
+	__m512i c1;
+	__m512i c2;
+	__m512i c3;
+	__m512i c4;
+	__m512i d0;
+	__m512i d1;
+	__m512i d2;
+	__m512i d3;
+	__m512i d4;
+
+	for (size_t i = 0U; i < QSC_KECCAK_STATE_SIZE; ++i)
+	{
+		a[i] = _mm512_loadu_si512((const void*)(state + (i * SIAP_KECCAKX_LANES_MAX)));
+	}
+
+	for (size_t r = 0U; r < QSC_KECCAK_PERMUTATION_ROUNDS; ++r)
+	{
+		c0 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(a[0], a[5], a[10], 0x96), a[15], a[20], 0x96);
+		c1 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(a[1], a[6], a[11], 0x96), a[16], a[21], 0x96);
+		c2 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(a[2], a[7], a[12], 0x96), a[17], a[22], 0x96);
+		c3 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(a[3], a[8], a[13], 0x96), a[18], a[23], 0x96);
+		c4 = _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(a[4], a[9], a[14], 0x96), a[19], a[24], 0x96);
+		d0 = _mm512_xor_si512(c4, _mm512_rol_epi64(c1, 1));
+		d1 = _mm512_xor_si512(c0, _mm512_rol_epi64(c2, 1));
+		d2 = _mm512_xor_si512(c1, _mm512_rol_epi64(c3, 1));
+		d3 = _mm512_xor_si512(c2, _mm512_rol_epi64(c4, 1));
+		d4 = _mm512_xor_si512(c3, _mm512_rol_epi64(c0, 1));
+		b[0] = _mm512_xor_si512(a[0], d0);
+		b[16] = _mm512_rol_epi64(_mm512_xor_si512(a[5], d0), 36);
+		b[7] = _mm512_rol_epi64(_mm512_xor_si512(a[10], d0), 3);
+		b[23] = _mm512_rol_epi64(_mm512_xor_si512(a[15], d0), 41);
+		b[14] = _mm512_rol_epi64(_mm512_xor_si512(a[20], d0), 18);
+		b[10] = _mm512_rol_epi64(_mm512_xor_si512(a[1], d1), 1);
+		b[1] = _mm512_rol_epi64(_mm512_xor_si512(a[6], d1), 44);
+		b[17] = _mm512_rol_epi64(_mm512_xor_si512(a[11], d1), 10);
+		b[8] = _mm512_rol_epi64(_mm512_xor_si512(a[16], d1), 45);
+		b[24] = _mm512_rol_epi64(_mm512_xor_si512(a[21], d1), 2);
+		b[20] = _mm512_rol_epi64(_mm512_xor_si512(a[2], d2), 62);
+		b[11] = _mm512_rol_epi64(_mm512_xor_si512(a[7], d2), 6);
+		b[2] = _mm512_rol_epi64(_mm512_xor_si512(a[12], d2), 43);
+		b[18] = _mm512_rol_epi64(_mm512_xor_si512(a[17], d2), 15);
+		b[9] = _mm512_rol_epi64(_mm512_xor_si512(a[22], d2), 61);
+		b[5] = _mm512_rol_epi64(_mm512_xor_si512(a[3], d3), 28);
+		b[21] = _mm512_rol_epi64(_mm512_xor_si512(a[8], d3), 55);
+		b[12] = _mm512_rol_epi64(_mm512_xor_si512(a[13], d3), 25);
+		b[3] = _mm512_rol_epi64(_mm512_xor_si512(a[18], d3), 21);
+		b[19] = _mm512_rol_epi64(_mm512_xor_si512(a[23], d3), 56);
+		b[15] = _mm512_rol_epi64(_mm512_xor_si512(a[4], d4), 27);
+		b[6] = _mm512_rol_epi64(_mm512_xor_si512(a[9], d4), 20);
+		b[22] = _mm512_rol_epi64(_mm512_xor_si512(a[14], d4), 39);
+		b[13] = _mm512_rol_epi64(_mm512_xor_si512(a[19], d4), 8);
+		b[4] = _mm512_rol_epi64(_mm512_xor_si512(a[24], d4), 14);
+		a[0] = _mm512_ternarylogic_epi64(b[0], b[1], b[2], 0xD2);
+		a[1] = _mm512_ternarylogic_epi64(b[1], b[2], b[3], 0xD2);
+		a[2] = _mm512_ternarylogic_epi64(b[2], b[3], b[4], 0xD2);
+		a[3] = _mm512_ternarylogic_epi64(b[3], b[4], b[0], 0xD2);
+		a[4] = _mm512_ternarylogic_epi64(b[4], b[0], b[1], 0xD2);
+		a[5] = _mm512_ternarylogic_epi64(b[5], b[6], b[7], 0xD2);
+		a[6] = _mm512_ternarylogic_epi64(b[6], b[7], b[8], 0xD2);
+		a[7] = _mm512_ternarylogic_epi64(b[7], b[8], b[9], 0xD2);
+		a[8] = _mm512_ternarylogic_epi64(b[8], b[9], b[5], 0xD2);
+		a[9] = _mm512_ternarylogic_epi64(b[9], b[5], b[6], 0xD2);
+		a[10] = _mm512_ternarylogic_epi64(b[10], b[11], b[12], 0xD2);
+		a[11] = _mm512_ternarylogic_epi64(b[11], b[12], b[13], 0xD2);
+		a[12] = _mm512_ternarylogic_epi64(b[12], b[13], b[14], 0xD2);
+		a[13] = _mm512_ternarylogic_epi64(b[13], b[14], b[10], 0xD2);
+		a[14] = _mm512_ternarylogic_epi64(b[14], b[10], b[11], 0xD2);
+		a[15] = _mm512_ternarylogic_epi64(b[15], b[16], b[17], 0xD2);
+		a[16] = _mm512_ternarylogic_epi64(b[16], b[17], b[18], 0xD2);
+		a[17] = _mm512_ternarylogic_epi64(b[17], b[18], b[19], 0xD2);
+		a[18] = _mm512_ternarylogic_epi64(b[18], b[19], b[15], 0xD2);
+		a[19] = _mm512_ternarylogic_epi64(b[19], b[15], b[16], 0xD2);
+		a[20] = _mm512_ternarylogic_epi64(b[20], b[21], b[22], 0xD2);
+		a[21] = _mm512_ternarylogic_epi64(b[21], b[22], b[23], 0xD2);
+		a[22] = _mm512_ternarylogic_epi64(b[22], b[23], b[24], 0xD2);
+		a[23] = _mm512_ternarylogic_epi64(b[23], b[24], b[20], 0xD2);
+		a[24] = _mm512_ternarylogic_epi64(b[24], b[20], b[21], 0xD2);
+		a[0] = _mm512_xor_si512(a[0], _mm512_set1_epi64((int64_t)KECCAKX_ROUND_CONSTANTS[r]));
+	}
+
+	for (size_t i = 0U; i < QSC_KECCAK_STATE_SIZE; ++i)
+	{
+		_mm512_storeu_si512((void*)(state + (i * SIAP_KECCAKX_LANES_MAX)), a[i]);
+	}
+}
+#endif
+
+static size_t keccakx_encode_length(size_t value)
+{
+	size_t n;
+
+	n = 1U;
+
+	while (n < sizeof(size_t) && (value >> (8U * n)) != 0U)
+	{
+		++n;
+	}
+
+	return n;
+}
+
+static size_t keccakx_lanes_detect(void)
+{
+	size_t res;
+
+	res = 1U;
+
+#if defined(KECCAKX_DISPATCH_X4) || defined(KECCAKX_DISPATCH_X8)
+	__builtin_cpu_init();
+#endif
+#if defined(KECCAKX_HAS_X4)
+#	if defined(KECCAKX_DISPATCH_X4)
+	if (__builtin_cpu_supports("avx2"))
+#	endif
+	{
+		res = 4U;
+	}
+#endif
+#if defined(KECCAKX_HAS_X8)
+#	if defined(KECCAKX_DISPATCH_X8)
+	if (__builtin_cpu_supports("avx512f"))
+#	endif
+	{
+		res = 8U;
+	}
+#endif
+
+	return res;
+}
+
+#if defined(KECCAKX_DISPATCH_X4) || defined(KECCAKX_DISPATCH_X8)
+/* the processor is probed once when the library is loaded, before any thread can hash; the scalar path is used until then */
+static size_t keccakx_lanes_probed = 1U;
+
+__attribute__((constructor)) static void keccakx_lanes_probe(void)
+{
+	keccakx_lanes_probed = keccakx_lanes_detect();
+}
+#endif
+
+static size_t keccakx_lanes_available(void)
+{
+#if defined(KECCAKX_DISPATCH_X4) || defined(KECCAKX_DISPATCH_X8)
+	return keccakx_lanes_probed;
+#else
+	/* the lanes are fixed by the build flags */
+	return keccakx_lanes_detect();
+#endif
+}
+
+static void keccakx_self_test_input(uint8_t* key, uint8_t* custom, size_t lane, size_t round)
+{
+	for (size_t i = 0U; i < KECCAKX_SELF_TEST_KEY; ++i)
+	{
+		key[i] = (uint8_t)((lane * 31U) + (i * 7U) + round);
+	}
+
+	for (size_t i = 0U; i < KECCAKX_SELF_TEST_CUSTOM; ++i)
+	{
+		custom[i] = (uint8_t)(lane + i);
+	}
+}
+
+static void keccakx_absorb_block(uint64_t* state, size_t stride, size_t lane, const uint8_t* block, size_t rate)
+{
+	for (size_t i = 0U; i < rate / sizeof(uint64_t); ++i)
+	{
+		state[(i * stride) + lane] ^= qsc_intutils_le8to64(block + (i * sizeof(uint64_t)));
+	}
+}
+
+static void keccakx_permute(qsc_keccak_state* kctx, uint64_t* state, size_t lanes)
+{
+#if defined(KECCAKX_HAS_X8)
+	if (lanes == 8U)
+	{
+		keccakx_permute_x8(state);
+	}
+	else
+#endif
+#if defined(KECCAKX_HAS_X4)
+	if (lanes == 4U)
+	{
+		keccakx_permute_x4(state);
+	}
+	else
+#endif
+	{
+		/* the scalar lane is stored contiguously in the QSC state */
+		(void)state;
+		(void)lanes;
+		qsc_keccak_permute(kctx, QSC_KECCAK_PERMUTATION_ROUNDS);
+	}
+}
+
+static void keccakx_sponge(uint8_t* const* output, size_t outlen, const uint8_t* const* message, size_t msglen, size_t rate, uint8_t domain, size_t lanes)
+{
+	uint64_t xstate[QSC_KECCAK_STATE_SIZE * SIAP_KECCAKX_LANES_MAX] = { 0U };
+	uint8_t pad[QSC_KECCAK_STATE_BYTE_SIZE] = { 0U };
+	qsc_keccak_state kctx = { 0 };
+	uint64_t* pst;
+	size_t blen;
+	size_t mpos;
+	size_t opos;
+	size_t stride;
+
+	/* a single lane uses the QSC state directly, with a stride of one */
+	pst = (lanes == 1U) ? kctx.state : xstate;
+	stride = (lanes == 1U) ? 1U : SIAP_KECCAKX_LANES_MAX;
+	mpos = 0U;
+
+	/* absorb the full message blocks */
+	while (msglen - mpos >= rate)
+	{
+		for (size_t j = 0U; j < lanes; ++j)
+		{
+			keccakx_absorb_block(pst, stride, j, message[j] + mpos, rate);
+		}
+
+		keccakx_permute(&kctx, pst, lanes);
+		mpos += rate;
+	}
+
+	/* pad and absorb the final block */
+	blen = msglen - mpos;
+
+	for (size_t j = 0U; j < lanes; ++j)
+	{
+		qsc_memutils_clear(pad, rate);
+		qsc_memutils_copy(pad, message[j] + mpos, blen);
+		pad[blen] ^= domain;
+		pad[rate - 1U] |= 0x80U;
+		keccakx_absorb_block(pst, stride, j, pad, rate);
+	}
+
+	/* squeeze the output */
+	opos = 0U;
+
+	while (opos < outlen)
+	{
+		keccakx_permute(&kctx, pst, lanes);
+		blen = (outlen - opos < rate) ? outlen - opos : rate;
+
+		for (size_t j = 0U; j < lanes; ++j)
+		{
+			for (size_t i = 0U; i < rate / sizeof(uint64_t); ++i)
+			{
+				qsc_intutils_le64to8(pad + (i * sizeof(uint64_t)), pst[(i * stride) + j]);
+			}
+
+			qsc_memutils_copy(output[j] + opos, pad, blen);
+		}
+
+		opos += blen;
+	}
+
+	qsc_memutils_secure_erase(xstate, sizeof(xstate));
+	qsc_memutils_secure_erase(pad, sizeof(pad));
+	qsc_keccak_dispose(&kctx);
+}
+
+bool siap_keccakx_cshake_encode(siap_cshake_encoded* enc, qsc_keccak_rate rate, const uint8_t* key, size_t keylen, const uint8_t* name, size_t namelen, const uint8_t* custom, size_t custlen)
+{
+	SIAP_ASSERT(enc != NULL);
+	SIAP_ASSERT(rate != qsc_keccak_rate_none);
+
+	uint8_t tmp[sizeof(size_t) + 1U] = { 0U };
+	size_t blen;
+	size_t pos;
+	bool res;
+
+	res = false;
+
+	if (enc != NULL && rate != qsc_keccak_rate_none)
+	{
+		qsc_memutils_clear(enc->message, sizeof(enc->message));
+		enc->rate = rate;
+		pos = 0U;
+
+		if (namelen + custlen != 0U)
+		{
+			/* bytepad(encode_string(N) || encode_string(S), rate) */
+			blen = siap_keccakx_left_encode(tmp, (size_t)rate) + siap_keccakx_left_encode(tmp, namelen * 8U) + namelen +
+				siap_keccakx_left_encode(tmp, custlen * 8U) + custlen;
+			blen = ((blen + (size_t)rate - 1U) / (size_t)rate) * (size_t)rate;
+
+			if (blen + keylen <= sizeof(enc->message))
+			{
+				pos = siap_keccakx_left_encode(enc->message, (size_t)rate);
+				pos += siap_keccakx_left_encode(enc->message + pos, namelen * 8U);
+				enc->namepos = pos;
+				qsc_memutils_copy(enc->message + pos, name, namelen);
+				pos += namelen;
+				pos += siap_keccakx_left_encode(enc->message + pos, custlen * 8U);
+				enc->custpos = pos;
+				qsc_memutils_copy(enc->message + pos, custom, custlen);
+				pos = blen;
+				enc->domain = QSC_KECCAK_CSHAKE_DOMAIN_ID;
+				res = true;
+			}
+		}
+		else if (keylen <= sizeof(enc->message))
+		{
+			/* an empty name and customization is plain SHAKE */
+			enc->namepos = 0U;
+			enc->custpos = 0U;
+			enc->domain = QSC_KECCAK_SHAKE_DOMAIN_ID;
+			res = true;
+		}
+
+		if (res == true)
+		{
+			if (keylen != 0U)
+			{
+				qsc_memutils_copy(enc->message + pos, key, keylen);
+			}
+
+			enc->keypos = pos;
+			enc->msglen = pos + keylen;
+		}
+	}
+
+	return res;
+}
+
+void siap_keccakx_cshake_compute(uint8_t* output, size_t outlen, const siap_cshake_encoded* enc)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(enc != NULL);
+
+	const uint8_t* pmsg[1U];
+	uint8_t* pout[1U];
+
+	if (output != NULL && enc != NULL)
+	{
+		pmsg[0U] = enc->message;
+		pout[0U] = output;
+		keccakx_sponge(pout, outlen, pmsg, enc->msglen, (size_t)enc->rate, enc->domain, 1U);
+	}
+}
+
+void siap_keccakx_compute(uint8_t* const* output, size_t outlen, const uint8_t* const* message, size_t msglen, qsc_keccak_rate rate, uint8_t domain, size_t count)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(message != NULL);
+	SIAP_ASSERT(rate != qsc_keccak_rate_none);
+
+	size_t i;
+	size_t lanes;
+
+	if (output != NULL && message != NULL && rate != qsc_keccak_rate_none)
+	{
+		i = 0U;
+		lanes = (count >= 4U) ? keccakx_lanes_available() : 1U;
+
+		if (lanes == 8U)
+		{
+			for (; i + 8U <= count; i += 8U)
+			{
+				keccakx_sponge(output + i, outlen, message + i, msglen, (size_t)rate, domain, 8U);
+			}
+		}
+
+		if (lanes >= 4U)
+		{
+			for (; i + 4U <= count; i += 4U)
+			{
+				keccakx_sponge(output + i, outlen, message + i, msglen, (size_t)rate, domain, 4U);
+			}
+		}
+
+		for (; i < count; ++i)
+		{
+			keccakx_sponge(output + i, outlen, message + i, msglen, (size_t)rate, domain, 1U);
+		}
+	}
+}
+
+size_t siap_keccakx_left_encode(uint8_t* output, size_t value)
+{
+	SIAP_ASSERT(output != NULL);
+
+	size_t n;
+
+	n = keccakx_encode_length(value);
+	output[0U] = (uint8_t)n;
+
+	for (size_t i = 1U; i <= n; ++i)
+	{
+		output[i] = (uint8_t)(value >> (8U * (n - i)));
+	}
+
+	return n + 1U;
+}
+
+size_t siap_keccakx_right_encode(uint8_t* output, size_t value)
+{
+	SIAP_ASSERT(output != NULL);
+
+	size_t n;
+
+	n = keccakx_encode_length(value);
+
+	for (size_t i = 0U; i < n; ++i)
+	{
+		output[i] = (uint8_t)(value >> (8U * (n - i - 1U)));
+	}
+
+	output[n] = (uint8_t)n;
+
+	return n + 1U;
+}
+
+void siap_keccakx_stream_absorb(siap_keccakx_stream* stream, const uint8_t* input, size_t inplen)
+{
+	SIAP_ASSERT(stream != NULL);
+	SIAP_ASSERT(input != NULL || inplen == 0U);
+
+	size_t blen;
+	size_t pos;
+	size_t rate;
+
+	if (stream != NULL && (input != NULL || inplen == 0U))
+	{
+		rate = (size_t)stream->rate;
+		pos = 0U;
+
+		while (pos < inplen)
+		{
+			if (stream->position == 0U && inplen - pos >= rate)
+			{
+				/* absorb full blocks directly from the input */
+				keccakx_absorb_block(stream->kstate.state, 1U, 0U, input + pos, rate);
+				qsc_keccak_permute(&stream->kstate, QSC_KECCAK_PERMUTATION_ROUNDS);
+				pos += rate;
+			}
+			else
+			{
+				blen = (inplen - pos < rate - stream->position) ? inplen - pos : rate - stream->position;
+				qsc_memutils_copy(stream->buffer + stream->position, input + pos, blen);
+				stream->position += blen;
+				pos += blen;
+
+				if (stream->position == rate)
+				{
+					keccakx_absorb_block(stream->kstate.state, 1U, 0U, stream->buffer, rate);
+					qsc_keccak_permute(&stream->kstate, QSC_KECCAK_PERMUTATION_ROUNDS);
+					stream->position = 0U;
+				}
+			}
+		}
+	}
+}
+
+void siap_keccakx_stream_dispose(siap_keccakx_stream* stream)
+{
+	if (stream != NULL)
+	{
+		qsc_memutils_secure_erase(stream, sizeof(siap_keccakx_stream));
+	}
+}
+
+void siap_keccakx_stream_finalize(siap_keccakx_stream* stream, uint8_t domain)
+{
+	SIAP_ASSERT(stream != NULL);
+
+	size_t rate;
+
+	if (stream != NULL)
+	{
+		rate = (size_t)stream->rate;
+		qsc_memutils_clear(stream->buffer + stream->position, rate - stream->position);
+		stream->buffer[stream->position] ^= domain;
+		stream->buffer[rate - 1U] |= 0x80U;
+		keccakx_absorb_block(stream->kstate.state, 1U, 0U, stream->buffer, rate);
+		/* the buffer is empty; the first squeeze permutes */
+		stream->position = rate;
+	}
+}
+
+void siap_keccakx_stream_initialize(siap_keccakx_stream* stream, qsc_keccak_rate rate)
+{
+	SIAP_ASSERT(stream != NULL);
+	SIAP_ASSERT(rate != qsc_keccak_rate_none);
+
+	if (stream != NULL && rate != qsc_keccak_rate_none)
+	{
+		qsc_memutils_clear(stream, sizeof(siap_keccakx_stream));
+		stream->rate = rate;
+	}
+}
+
+void siap_keccakx_stream_squeeze(siap_keccakx_stream* stream, uint8_t* output, size_t outlen)
+{
+	SIAP_ASSERT(stream != NULL);
+	SIAP_ASSERT(output != NULL);
+
+	size_t blen;
+	size_t opos;
+	size_t rate;
+
+	if (stream != NULL && output != NULL)
+	{
+		rate = (size_t)stream->rate;
+		opos = 0U;
+
+		while (opos < outlen)
+		{
+			if (stream->position == rate)
+			{
+				qsc_keccak_permute(&stream->kstate, QSC_KECCAK_PERMUTATION_ROUNDS);
+
+				for (size_t i = 0U; i < rate / sizeof(uint64_t); ++i)
+				{
+					qsc_intutils_le64to8(stream->buffer + (i * sizeof(uint64_t)), stream->kstate.state[i]);
+				}
+
+				stream->position = 0U;
+			}
+
+			blen = (outlen - opos < rate - stream->position) ? outlen - opos : rate - stream->position;
+			qsc_memutils_copy(output + opos, stream->buffer + stream->position, blen);
+			stream->position += blen;
+			opos += blen;
+		}
+	}
+}
+
+size_t siap_keccakx_lanes(void)
+{
+	return keccakx_lanes_available();
+}
+
+bool siap_keccakx_self_test(void)
+{
+	const qsc_keccak_rate rates[2U] = { qsc_keccak_rate_256, qsc_keccak_rate_512 };
+	const uint8_t name[] = { 0x6B, 0x65, 0x63, 0x63, 0x61, 0x6B, 0x78 };
+	uint8_t custom[KECCAKX_SELF_TEST_CUSTOM] = { 0U };
+	uint8_t key[KECCAKX_SELF_TEST_KEY] = { 0U };
+	uint8_t exp[KECCAKX_SELF_TEST_OUTPUT] = { 0U };
+	uint8_t otp[KECCAKX_SELF_TEST_LANES][KECCAKX_SELF_TEST_OUTPUT] = { 0U };
+	siap_cshake_encoded enc[KECCAKX_SELF_TEST_LANES] = { 0 };
+	const uint8_t* pmsg[KECCAKX_SELF_TEST_LANES];
+	uint8_t* pout[KECCAKX_SELF_TEST_LANES];
+	bool res;
+
+	res = true;
+
+	/* thirteen messages run the 8 and 4 lane kernels the processor supports and the scalar tail,
+	   each message spans several absorb blocks and each output several squeeze blocks */
+	for (size_t r = 0U; r < 2U && res == true; ++r)
+	{
+		for (size_t j = 0U; j < KECCAKX_SELF_TEST_LANES && res == true; ++j)
+		{
+			keccakx_self_test_input(key, custom, j, r);
+
+			res = siap_keccakx_cshake_encode(&enc[j], rates[r], key, sizeof(key), name, sizeof(name), custom, sizeof(custom));
+			pmsg[j] = enc[j].message;
+			pout[j] = otp[j];
+		}
+
+		if (res == true)
+		{
+			siap_keccakx_compute(pout, sizeof(exp), pmsg, enc[0U].msglen, rates[r], enc[0U].domain, KECCAKX_SELF_TEST_LANES);
+
+			for (size_t j = 0U; j < KECCAKX_SELF_TEST_LANES && res == true; ++j)
+			{
+				keccakx_self_test_input(key, custom, j, r);
+
+				if (rates[r] == qsc_keccak_rate_512)
+				{
+					qsc_cshake512_compute(exp, sizeof(exp), key, sizeof(key), name, sizeof(name), custom, sizeof(custom));
+				}
+				else
+				{
+					qsc_cshake256_compute(exp, sizeof(exp), key, sizeof(key), name, sizeof(name), custom, sizeof(custom));
+				}
+
+				res = qsc_memutils_are_equal(exp, otp[j], sizeof(exp));
+			}
+		}
+	}
+
+	qsc_memutils_clear(enc, sizeof(enc));
+	qsc_memutils_clear(otp, sizeof(otp));
+
+	return res;
+}
@@ -0,0 +1,234 @@
+/* 2025-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SIAP_KECCAKX_H
+#define SIAP_KECCAKX_H
+
+#include "siapcommon.h"
+#include "sha3.h"
+
+/**
+* \file keccakx.h
+* \brief SIAP multi-buffer Keccak functions.
+*
+* \details
+* Computes several independent Keccak sponge instances in parallel, one instance per vector lane.
+* The 8-lane path uses AVX-512, the 4-lane path uses AVX2, and any remaining messages are processed by the
+* scalar QSC permutation, so the output of every lane is identical to a serial computation.
+* On GCC and Clang x86 builds, the vector paths are compiled regardless of the build flags, and the widest path
+* the processor supports is selected once when the library is loaded, so a generic build runs the vector paths on capable hosts.
+* Only these multi-buffer Keccak kernels are selected at runtime; the RCS cipher and the single-message SHA-3 functions
+* use the paths QSC was built with.
+*
+* The cSHAKE encoder pre-computes the bytepad(encode_string(N) || encode_string(S)) block followed by the key,
+* so that callers deriving many outputs that differ only in a fixed-length name or customization field can
+* overwrite that field in place and hash the result with \c siap_keccakx_compute.
+*/
+
+/*!
+* \def SIAP_KECCAKX_LANES_MAX
+* \brief The maximum number of messages processed in a single permutation sweep.
+*/
+#define SIAP_KECCAKX_LANES_MAX 8U
+
+/*!
+* \def SIAP_KECCAKX_MESSAGE_MAX
+* \brief The maximum size of a pre-encoded cSHAKE message in bytes.
+*/
+#define SIAP_KECCAKX_MESSAGE_MAX (3U * QSC_KECCAK_256_RATE)
+
+/*!
+ * \struct siap_cshake_encoded
+ * \brief A pre-encoded cSHAKE input.
+ * This structure contains the padded customization block and the key, ready to be absorbed.
+ */
+SIAP_EXPORT_API typedef struct siap_cshake_encoded
+{
+	uint8_t message[SIAP_KECCAKX_MESSAGE_MAX];	/*!< The encoded customization block and key */
+	size_t msglen;								/*!< The encoded message length */
+	size_t namepos;								/*!< The position of the name string in the message */
+	size_t custpos;								/*!< The position of the customization string in the message */
+	size_t keypos;								/*!< The position of the key in the message */
+	qsc_keccak_rate rate;						/*!< The Keccak rate */
+	uint8_t domain;								/*!< The Keccak domain identifier */
+} siap_cshake_encoded;
+
+/*!
+ * \struct siap_keccakx_stream
+ * \brief An incremental scalar Keccak sponge.
+ * Used to absorb long or chunked inputs with constant memory.
+ */
+SIAP_EXPORT_API typedef struct siap_keccakx_stream
+{
+	qsc_keccak_state kstate;					/*!< The Keccak state */
+	uint8_t buffer[QSC_KECCAK_STATE_BYTE_SIZE];	/*!< The partial block buffer */
+	size_t position;							/*!< The buffer position */
+	qsc_keccak_rate rate;						/*!< The Keccak rate */
+} siap_keccakx_stream;
+
+/**
+ * \brief Encode the cSHAKE customization block and key.
+ * The output is bit-compatible with the QSC cSHAKE compute functions using the same parameters.
+ *
+ * \param enc A pointer to the output encoded message structure.
+ * \param rate The Keccak rate.
+ * \param key [const] The key array.
+ * \param keylen The key length in bytes.
+ * \param name [const] The function name string.
+ * \param namelen The function name length in bytes.
+ * \param custom [const] The customization string.
+ * \param custlen The customization string length in bytes.
+ *
+ * \return Returns false if the encoded message exceeds \c SIAP_KECCAKX_MESSAGE_MAX.
+ */
+SIAP_EXPORT_API bool siap_keccakx_cshake_encode(siap_cshake_encoded* enc, qsc_keccak_rate rate, const uint8_t* key, size_t keylen, const uint8_t* name, size_t namelen, const uint8_t* custom, size_t custlen);
+
+/**
+ * \brief Compute a single cSHAKE output from a pre-encoded message.
+ *
+ * \param output The output array.
+ * \param outlen The number of output bytes.
+ * \param enc [const] A pointer to the encoded message structure.
+ */
+SIAP_EXPORT_API void siap_keccakx_cshake_compute(uint8_t* output, size_t outlen, const siap_cshake_encoded* enc);
+
+/**
+ * \brief Compute several independent Keccak sponge outputs of equal-length messages.
+ * Messages are processed in groups of the widest lane count supported by the build, with a scalar tail.
+ *
+ * \param output The array of output pointers.
+ * \param outlen The number of bytes written to each output.
+ * \param message [const] The array of message pointers.
+ * \param msglen The length of each message in bytes.
+ * \param rate The Keccak rate.
+ * \param domain The Keccak domain identifier used in the final padding.
+ * \param count The number of messages.
+ */
+SIAP_EXPORT_API void siap_keccakx_compute(uint8_t* const* output, size_t outlen, const uint8_t* const* message, size_t msglen, qsc_keccak_rate rate, uint8_t domain, size_t count);
+
+/**
+ * \brief Write the SP 800-185 left_encode of a value.
+ *
+ * \param output The output array, at least sizeof(size_t) + 1 bytes.
+ * \param value The value to encode.
+ *
+ * \return Returns the number of bytes written.
+ */
+SIAP_EXPORT_API size_t siap_keccakx_left_encode(uint8_t* output, size_t value);
+
+/**
+ * \brief Write the SP 800-185 right_encode of a value.
+ *
+ * \param output The output array, at least sizeof(size_t) + 1 bytes.
+ * \param value The value to encode.
+ *
+ * \return Returns the number of bytes written.
+ */
+SIAP_EXPORT_API size_t siap_keccakx_right_encode(uint8_t* output, size_t value);
+
+/**
+ * \brief Absorb bytes into an incremental sponge.
+ *
+ * \param stream A pointer to the sponge state.
+ * \param input [const] The input array.
+ * \param inplen The number of input bytes.
+ */
+SIAP_EXPORT_API void siap_keccakx_stream_absorb(siap_keccakx_stream* stream, const uint8_t* input, size_t inplen);
+
+/**
+ * \brief Erase an incremental sponge.
+ *
+ * \param stream A pointer to the sponge state.
+ */
+SIAP_EXPORT_API void siap_keccakx_stream_dispose(siap_keccakx_stream* stream);
+
+/**
+ * \brief Pad the final block of an incremental sponge; no further input can be absorbed.
+ *
+ * \param stream A pointer to the sponge state.
+ * \param domain The Keccak domain identifier.
+ */
+SIAP_EXPORT_API void siap_keccakx_stream_finalize(siap_keccakx_stream* stream, uint8_t domain);
+
+/**
+ * \brief Initialize an incremental sponge.
+ *
+ * \param stream A pointer to the sponge state.
+ * \param rate The Keccak rate.
+ */
+SIAP_EXPORT_API void siap_keccakx_stream_initialize(siap_keccakx_stream* stream, qsc_keccak_rate rate);
+
+/**
+ * \brief Squeeze output bytes from a finalized sponge; may be called repeatedly.
+ *
+ * \param stream A pointer to the sponge state.
+ * \param output The output array.
+ * \param outlen The number of output bytes.
+ */
+SIAP_EXPORT_API void siap_keccakx_stream_squeeze(siap_keccakx_stream* stream, uint8_t* output, size_t outlen);
+
+/**
+ * \brief Get the number of parallel lanes used on this processor.
+ *
+ * \return Returns 8 with AVX-512, 4 with AVX2, otherwise 1.
+ */
+SIAP_EXPORT_API size_t siap_keccakx_lanes(void);
+
+/**
+ * \brief Compare the multi-buffer lanes against the scalar QSC cSHAKE for known inputs.
+ * Runs cSHAKE-256 and cSHAKE-512 over enough messages to use every vector path the processor supports,
+ * so a fault in one SIMD kernel is detected before it derives keys.
+ *
+ * \return Returns true if every lane matches the scalar output.
+ */
+SIAP_EXPORT_API bool siap_keccakx_self_test(void);
+
+#endif
@@ -0,0 +1,605 @@
+#include "khash.h"
+#include "affinity.h"
+#include "keccakx.h"
+#include "intutils.h"
+#include "memutils.h"
+#include "sha3.h"
+
+#if defined(SIAP_EXTENDED_ENCRYPTION)
+#	define KHASH_KECCAK_RATE qsc_keccak_rate_512
+#else
+#	define KHASH_KECCAK_RATE qsc_keccak_rate_256
+#endif
+
+#define KHASH_MERKLE_CHUNK 32U
+#define KHASH_MERKLE_LEAF_DOMAIN 0x00U
+#define KHASH_MERKLE_LEAF_SIZE (1U + SIAP_AUTHENTICATION_TOKEN_SIZE)
+#define KHASH_MERKLE_NODE_DOMAIN 0x01U
+#define KHASH_MERKLE_NODE_SIZE (1U + (2U * SIAP_KTAG_STATE_HASH))
+#define KHASH_THREADS_MAX 64U
+
+static const char KHASH_PARALLEL_NAME[] = "ParallelHash";
+
+typedef struct khash_parallel_task
+{
+	uint8_t* output;
+	const uint8_t* input;
+	size_t inplen;
+	size_t first;
+	size_t count;
+} khash_parallel_task;
+
+static size_t khash_log2(size_t value)
+{
+	size_t n;
+
+	n = 0U;
+
+	while ((value >> n) > 1U)
+	{
+		++n;
+	}
+
+	return n;
+}
+
+static bool khash_is_power2(size_t value)
+{
+	return (value != 0U && (value & (value - 1U)) == 0U);
+}
+
+static void khash_merkle_hash(uint8_t* output, const uint8_t* input, size_t inplen, size_t msglen, uint8_t domain, size_t count)
+{
+	/* hash count prefixed inputs of inplen bytes each, output may overlap the input */
+	uint8_t msg[SIAP_KECCAKX_LANES_MAX][KHASH_MERKLE_NODE_SIZE > KHASH_MERKLE_LEAF_SIZE ? KHASH_MERKLE_NODE_SIZE : KHASH_MERKLE_LEAF_SIZE];
+	const uint8_t* pmsg[SIAP_KECCAKX_LANES_MAX];
+	uint8_t* pout[SIAP_KECCAKX_LANES_MAX];
+	size_t lanes;
+
+	for (size_t i = 0U; i < count; i += SIAP_KECCAKX_LANES_MAX)
+	{
+		lanes = (count - i < SIAP_KECCAKX_LANES_MAX) ? count - i : SIAP_KECCAKX_LANES_MAX;
+
+		for (size_t j = 0U; j < lanes; ++j)
+		{
+			msg[j][0U] = domain;
+			qsc_memutils_copy(msg[j] + 1U, input + ((i + j) * inplen), inplen);
+			pmsg[j] = msg[j];
+			pout[j] = output + ((i + j) * SIAP_KTAG_STATE_HASH);
+		}
+
+		siap_keccakx_compute(pout, SIAP_KTAG_STATE_HASH, pmsg, msglen, KHASH_KECCAK_RATE, QSC_KECCAK_SHAKE_DOMAIN_ID, lanes);
+	}
+
+	qsc_memutils_secure_erase(msg, sizeof(msg));
+}
+
+static void khash_merkle_leaves(uint8_t* output, const uint8_t* tokens, size_t count)
+{
+	khash_merkle_hash(output, tokens, SIAP_AUTHENTICATION_TOKEN_SIZE, KHASH_MERKLE_LEAF_SIZE, KHASH_MERKLE_LEAF_DOMAIN, count);
+}
+
+static void khash_merkle_nodes(uint8_t* output, const uint8_t* children, size_t count)
+{
+	khash_merkle_hash(output, children, 2U * SIAP_KTAG_STATE_HASH, KHASH_MERKLE_NODE_SIZE, KHASH_MERKLE_NODE_DOMAIN, count);
+}
+
+static void khash_merkle_subtree(uint8_t* output, uint8_t* path, const uint8_t* tree, size_t first, size_t count, size_t leaf)
+{
+	/* compute the root of count tokens starting at first, and record the path siblings of leaf if it is in range */
+	uint8_t nodes[KHASH_MERKLE_CHUNK * SIAP_KTAG_STATE_HASH];
+	bool inrange;
+	size_t height;
+	size_t idx;
+
+	inrange = (path != NULL && leaf >= first && leaf - first < count);
+
+	if (count <= KHASH_MERKLE_CHUNK)
+	{
+		khash_merkle_leaves(nodes, tree + (first * SIAP_AUTHENTICATION_TOKEN_SIZE), count);
+		idx = leaf - first;
+		height = 0U;
+
+		while (count > 1U)
+		{
+			if (inrange == true)
+			{
+				qsc_memutils_copy(path + (height * SIAP_KTAG_STATE_HASH), nodes + ((idx ^ 1U) * SIAP_KTAG_STATE_HASH), SIAP_KTAG_STATE_HASH);
+				idx >>= 1U;
+			}
+
+			count >>= 1U;
+			khash_merkle_nodes(nodes, nodes, count);
+			++height;
+		}
+
+		qsc_memutils_copy(output, nodes, SIAP_KTAG_STATE_HASH);
+	}
+	else
+	{
+		count >>= 1U;
+		khash_merkle_subtree(nodes, path, tree, first, count, leaf);
+		khash_merkle_subtree(nodes + SIAP_KTAG_STATE_HASH, path, tree, first + count, count, leaf);
+
+		if (inrange == true)
+		{
+			idx = (leaf - first < count) ? 1U : 0U;
+			qsc_memutils_copy(path + (khash_log2(count) * SIAP_KTAG_STATE_HASH), nodes + (idx * SIAP_KTAG_STATE_HASH), SIAP_KTAG_STATE_HASH);
+		}
+
+		khash_merkle_nodes(output, nodes, 1U);
+	}
+
+	qsc_memutils_secure_erase(nodes, sizeof(nodes));
+}
+
+static void khash_merkle_fold(uint8_t* root, const uint8_t* path, const uint8_t* token, size_t leaf, size_t depth)
+{
+	uint8_t pair[2U * SIAP_KTAG_STATE_HASH] = { 0U };
+	size_t idx;
+
+	khash_merkle_leaves(root, token, 1U);
+	idx = leaf;
+
+	for (size_t i = 0U; i < depth; ++i)
+	{
+		if ((idx & 1U) == 0U)
+		{
+			qsc_memutils_copy(pair, root, SIAP_KTAG_STATE_HASH);
+			qsc_memutils_copy(pair + SIAP_KTAG_STATE_HASH, path + (i * SIAP_KTAG_STATE_HASH), SIAP_KTAG_STATE_HASH);
+		}
+		else
+		{
+			qsc_memutils_copy(pair, path + (i * SIAP_KTAG_STATE_HASH), SIAP_KTAG_STATE_HASH);
+			qsc_memutils_copy(pair + SIAP_KTAG_STATE_HASH, root, SIAP_KTAG_STATE_HASH);
+		}
+
+		khash_merkle_nodes(root, pair, 1U);
+		idx >>= 1U;
+	}
+}
+
+static void khash_parallel_blocks(uint8_t* output, const uint8_t* input, size_t inplen, size_t first, size_t count)
+{
+	const uint8_t* pmsg[SIAP_KECCAKX_LANES_MAX];
+	uint8_t* pout[SIAP_KECCAKX_LANES_MAX];
+	size_t blen;
+	size_t end;
+	size_t idx;
+	size_t lanes;
+
+	end = first + count;
+	idx = first;
+
+	while (idx < end)
+	{
+		blen = inplen - (idx * SIAP_KHASH_BLOCK_SIZE);
+		lanes = 0U;
+
+		if (blen < SIAP_KHASH_BLOCK_SIZE)
+		{
+			/* the final block may be short */
+			pmsg[0U] = input + (idx * SIAP_KHASH_BLOCK_SIZE);
+			pout[0U] = output + ((idx - first) * SIAP_KHASH_LEAF_HASH_SIZE);
+			siap_keccakx_compute(pout, SIAP_KHASH_LEAF_HASH_SIZE, pmsg, blen, KHASH_KECCAK_RATE, QSC_KECCAK_SHAKE_DOMAIN_ID, 1U);
+			++idx;
+		}
+		else
+		{
+			/* gather up to a full sweep of full blocks */
+			while (lanes < SIAP_KECCAKX_LANES_MAX && idx + lanes < end &&
+				inplen - ((idx + lanes) * SIAP_KHASH_BLOCK_SIZE) >= SIAP_KHASH_BLOCK_SIZE)
+			{
+				pmsg[lanes] = input + ((idx + lanes) * SIAP_KHASH_BLOCK_SIZE);
+				pout[lanes] = output + ((idx + lanes - first) * SIAP_KHASH_LEAF_HASH_SIZE);
+				++lanes;
+			}
+
+			siap_keccakx_compute(pout, SIAP_KHASH_LEAF_HASH_SIZE, pmsg, SIAP_KHASH_BLOCK_SIZE, KHASH_KECCAK_RATE, QSC_KECCAK_SHAKE_DOMAIN_ID, lanes);
+			idx += lanes;
+		}
+	}
+}
+
+static void khash_parallel_worker(void* state)
+{
+	khash_parallel_task* task;
+
+	task = (khash_parallel_task*)state;
+	khash_parallel_blocks(task->output, task->input, task->inplen, task->first, task->count);
+}
+
+static bool khash_parallel_threaded(siap_keccakx_stream* stream, const uint8_t* input, size_t inplen, size_t bcount, size_t threads)
+{
+	khash_parallel_task tasks[KHASH_THREADS_MAX] = { 0 };
+	qsc_thread handles[KHASH_THREADS_MAX] = { 0 };
+	bool started[KHASH_THREADS_MAX] = { false };
+	uint8_t* lhash;
+	size_t first;
+	size_t tcount;
+	bool res;
+
+	res = false;
+	tcount = (threads < KHASH_THREADS_MAX) ? threads : KHASH_THREADS_MAX;
+	lhash = (uint8_t*)qsc_memutils_malloc(bcount * SIAP_KHASH_LEAF_HASH_SIZE);
+
+	if (lhash != NULL)
+	{
+		first = 0U;
+
+		/* divide the blocks evenly, the first workers take the remainder */
+		for (size_t i = 0U; i < tcount; ++i)
+		{
+			tasks[i].count = (bcount / tcount) + ((i < bcount % tcount) ? 1U : 0U);
+			tasks[i].first = first;
+			tasks[i].input = input;
+			tasks[i].inplen = inplen;
+			tasks[i].output = lhash + (first * SIAP_KHASH_LEAF_HASH_SIZE);
+			first += tasks[i].count;
+		}
+
+		/* the calling thread processes the first range, and any range whose thread did not start */
+		for (size_t i = 1U; i < tcount; ++i)
+		{
+			started[i] = siap_affinity_thread_create(&handles[i], &khash_parallel_worker, &tasks[i]);
+		}
+
+		for (size_t i = 0U; i < tcount; ++i)
+		{
+			if (started[i] == false)
+			{
+				khash_parallel_worker(&tasks[i]);
+			}
+		}
+
+		for (size_t i = 1U; i < tcount; ++i)
+		{
+			if (started[i] == true)
+			{
+				qsc_async_thread_wait(handles[i]);
+			}
+		}
+
+		siap_keccakx_stream_absorb(stream, lhash, bcount * SIAP_KHASH_LEAF_HASH_SIZE);
+		qsc_memutils_secure_erase(lhash, bcount * SIAP_KHASH_LEAF_HASH_SIZE);
+		qsc_memutils_alloc_free(lhash);
+		res = true;
+	}
+
+	return res;
+}
+
+bool siap_khash_compute(uint8_t* output, const uint8_t* input, size_t inplen, siap_khash_modes mode)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(input != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (output != NULL && input != NULL)
+	{
+		if (mode == siap_khash_mode_serial)
+		{
+			/* hash the entire key tree */
+#if defined(SIAP_EXTENDED_ENCRYPTION)
+			qsc_shake512_compute(output, SIAP_KTAG_STATE_HASH, input, inplen);
+#else
+			qsc_shake256_compute(output, SIAP_KTAG_STATE_HASH, input, inplen);
+#endif
+			res = true;
+		}
+		else if (mode == siap_khash_mode_parallel)
+		{
+			siap_khash_parallel_compute(output, input, inplen, SIAP_KHASH_THREADS);
+			res = true;
+		}
+		else if (mode == siap_khash_mode_merkle)
+		{
+			res = (inplen % SIAP_AUTHENTICATION_TOKEN_SIZE == 0U &&
+				siap_khash_merkle_compute(output, NULL, input, inplen / SIAP_AUTHENTICATION_TOKEN_SIZE, 0U) == true);
+		}
+	}
+
+	return res;
+}
+
+void siap_khash_finalize(siap_khash_state* state, uint8_t* output)
+{
+	SIAP_ASSERT(state != NULL);
+	SIAP_ASSERT(output != NULL);
+
+	uint8_t lhash[SIAP_KHASH_LEAF_HASH_SIZE] = { 0U };
+	uint8_t tmp[sizeof(size_t) + 1U] = { 0U };
+
+	if (state != NULL && output != NULL)
+	{
+		if (state->mode == siap_khash_mode_parallel)
+		{
+			if (state->position != 0U)
+			{
+				/* hash the short final block */
+				khash_parallel_blocks(lhash, state->buffer, state->position, 0U, 1U);
+				siap_keccakx_stream_absorb(&state->sponge, lhash, sizeof(lhash));
+				++state->bcount;
+			}
+
+			siap_keccakx_stream_absorb(&state->sponge, tmp, siap_keccakx_right_encode(tmp, state->bcount));
+			siap_keccakx_stream_absorb(&state->sponge, tmp, siap_keccakx_right_encode(tmp, SIAP_KTAG_STATE_HASH * 8U));
+			siap_keccakx_stream_finalize(&state->sponge, QSC_KECCAK_CSHAKE_DOMAIN_ID);
+		}
+		else
+		{
+			siap_keccakx_stream_finalize(&state->sponge, QSC_KECCAK_SHAKE_DOMAIN_ID);
+		}
+
+		siap_keccakx_stream_squeeze(&state->sponge, output, SIAP_KTAG_STATE_HASH);
+
+		/* cleanup */
+		qsc_memutils_secure_erase(lhash, sizeof(lhash));
+		qsc_memutils_secure_erase(state, sizeof(siap_khash_state));
+	}
+}
+
+bool siap_khash_initialize(siap_khash_state* state, siap_khash_modes mode)
+{
+	SIAP_ASSERT(state != NULL);
+
+	uint8_t tmp[sizeof(size_t) + 1U] = { 0U };
+	siap_cshake_encoded enc = { 0 };
+	bool res;
+
+	res = false;
+
+	if (state != NULL)
+	{
+		qsc_memutils_clear(state, sizeof(siap_khash_state));
+		siap_keccakx_stream_initialize(&state->sponge, KHASH_KECCAK_RATE);
+		state->mode = mode;
+
+		if (mode == siap_khash_mode_serial)
+		{
+			res = true;
+		}
+		else if (mode == siap_khash_mode_parallel)
+		{
+			/* cSHAKE(left_encode(B) || z[0] || ... || z[n-1] || right_encode(n) || right_encode(L), L, "ParallelHash", S) */
+			siap_keccakx_cshake_encode(&enc, KHASH_KECCAK_RATE, NULL, 0U, (const uint8_t*)KHASH_PARALLEL_NAME, sizeof(KHASH_PARALLEL_NAME) - 1U,
+				(const uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE);
+			siap_keccakx_stream_absorb(&state->sponge, enc.message, enc.msglen);
+			siap_keccakx_stream_absorb(&state->sponge, tmp, siap_keccakx_left_encode(tmp, SIAP_KHASH_BLOCK_SIZE));
+			/* a threaded hash needs the whole tree, the caller uses siap_khash_compute instead */
+#if (SIAP_KHASH_THREADS == 1U)
+			res = true;
+#endif
+		}
+	}
+
+	return res;
+}
+
+void siap_khash_mac_commit(uint8_t* output, const uint8_t* kid, const uint8_t* mac)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(kid != NULL);
+	SIAP_ASSERT(mac != NULL);
+
+	if (output != NULL && kid != NULL && mac != NULL)
+	{
+		/* the mac authenticates the whole ciphertext, the kid binds it to the current counter value */
+#if defined(SIAP_EXTENDED_ENCRYPTION)
+		qsc_cshake512_compute(output, SIAP_KTAG_STATE_HASH, mac, SIAP_MAC_SIZE, (const uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE, kid, SIAP_KID_SIZE);
+#else
+		qsc_cshake256_compute(output, SIAP_KTAG_STATE_HASH, mac, SIAP_MAC_SIZE, (const uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE, kid, SIAP_KID_SIZE);
+#endif
+	}
+}
+
+bool siap_khash_merkle_advance(uint8_t* root, uint8_t* path, const uint8_t* tree, size_t count, size_t leaf)
+{
+	SIAP_ASSERT(root != NULL);
+	SIAP_ASSERT(path != NULL);
+	SIAP_ASSERT(tree != NULL);
+
+	uint8_t zero[SIAP_AUTHENTICATION_TOKEN_SIZE] = { 0U };
+	uint8_t zpair[2U * SIAP_KTAG_STATE_HASH] = { 0U };
+	size_t depth;
+	bool res;
+
+	res = false;
+
+	if (root != NULL && path != NULL && tree != NULL && khash_is_power2(count) == true && leaf != 0U)
+	{
+		depth = khash_log2(count);
+
+		if (leaf < count)
+		{
+			/* zpair holds two copies of the all-zero subtree root at the current height */
+			khash_merkle_leaves(zpair, zero, 1U);
+
+			for (size_t i = 0U; i < depth; ++i)
+			{
+				if ((leaf >> i) != ((leaf - 1U) >> i))
+				{
+					if (((leaf >> i) & 1U) != 0U)
+					{
+						/* the left sibling now only covers erased tokens */
+						qsc_memutils_copy(path + (i * SIAP_KTAG_STATE_HASH), zpair, SIAP_KTAG_STATE_HASH);
+					}
+					else
+					{
+						/* the right sibling left the old path, hash it from the tree */
+						khash_merkle_subtree(path + (i * SIAP_KTAG_STATE_HASH), NULL, tree, ((leaf >> i) + 1U) << i, (size_t)1U << i, 0U);
+					}
+				}
+
+				qsc_memutils_copy(zpair + SIAP_KTAG_STATE_HASH, zpair, SIAP_KTAG_STATE_HASH);
+				khash_merkle_nodes(zpair, zpair, 1U);
+			}
+
+			khash_merkle_fold(root, path, tree + (leaf * SIAP_AUTHENTICATION_TOKEN_SIZE), leaf, depth);
+		}
+		else
+		{
+			/* every token has been used, recompute the final root */
+			siap_khash_merkle_compute(root, path, tree, count, leaf);
+		}
+
+		res = true;
+	}
+
+	return res;
+}
+
+bool siap_khash_merkle_compute(uint8_t* root, uint8_t* path, const uint8_t* tree, size_t count, size_t leaf)
+{
+	SIAP_ASSERT(root != NULL);
+	SIAP_ASSERT(tree != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (root != NULL && tree != NULL && khash_is_power2(count) == true)
+	{
+		if (path != NULL)
+		{
+			qsc_memutils_clear(path, khash_log2(count) * SIAP_KTAG_STATE_HASH);
+		}
+
+		khash_merkle_subtree(root, path, tree, 0U, count, leaf);
+		res = true;
+	}
+
+	return res;
+}
+
+bool siap_khash_merkle_verify(const uint8_t* root, const uint8_t* path, const uint8_t* token, size_t leaf, size_t depth)
+{
+	SIAP_ASSERT(root != NULL);
+	SIAP_ASSERT(path != NULL);
+	SIAP_ASSERT(token != NULL);
+
+	uint8_t tmph[SIAP_KTAG_STATE_HASH] = { 0U };
+	bool res;
+
+	res = false;
+
+	if (root != NULL && path != NULL && token != NULL && (leaf >> depth) == 0U)
+	{
+		khash_merkle_fold(tmph, path, token, leaf, depth);
+		res = (qsc_intutils_verify(tmph, root, SIAP_KTAG_STATE_HASH) == 0U);
+	}
+
+	return res;
+}
+
+void siap_khash_parallel_compute(uint8_t* output, const uint8_t* input, size_t inplen, size_t threads)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(input != NULL);
+
+	siap_khash_state state = { 0 };
+	size_t count;
+	bool res;
+
+	if (output != NULL && input != NULL)
+	{
+		siap_khash_initialize(&state, siap_khash_mode_parallel);
+		state.bcount = (inplen + SIAP_KHASH_BLOCK_SIZE - 1U) / SIAP_KHASH_BLOCK_SIZE;
+		res = false;
+
+		if (threads > 1U && state.bcount >= 2U * SIAP_KHASH_THREAD_BLOCKS)
+		{
+			count = state.bcount / SIAP_KHASH_THREAD_BLOCKS;
+			res = khash_parallel_threaded(&state.sponge, input, inplen, state.bcount, (count < threads) ? count : threads);
+		}
+
+		if (res == false)
+		{
+			state.bcount = 0U;
+			siap_khash_update(&state, input, inplen);
+		}
+
+		siap_khash_finalize(&state, output);
+	}
+}
+
+void siap_khash_segment_commit(uint8_t* output, uint32_t index, uint32_t sequence, const uint8_t* mac)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(mac != NULL);
+
+	uint8_t cust[2U * sizeof(uint32_t)] = { 0U };
+
+	if (output != NULL && mac != NULL)
+	{
+		qsc_intutils_be32to8(cust, index);
+		qsc_intutils_be32to8(cust + sizeof(uint32_t), sequence);
+#if defined(SIAP_EXTENDED_ENCRYPTION)
+		qsc_cshake512_compute(output, SIAP_KTAG_STATE_HASH, mac, SIAP_MAC_SIZE, (const uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE, cust, sizeof(cust));
+#else
+		qsc_cshake256_compute(output, SIAP_KTAG_STATE_HASH, mac, SIAP_MAC_SIZE, (const uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE, cust, sizeof(cust));
+#endif
+	}
+}
+
+void siap_khash_update(siap_khash_state* state, const uint8_t* input, size_t inplen)
+{
+	SIAP_ASSERT(state != NULL);
+	SIAP_ASSERT(input != NULL || inplen == 0U);
+
+	uint8_t lhash[SIAP_KECCAKX_LANES_MAX * SIAP_KHASH_LEAF_HASH_SIZE] = { 0U };
+	size_t blen;
+	size_t count;
+	size_t pos;
+
+	if (state != NULL && (input != NULL || inplen == 0U))
+	{
+		if (state->mode == siap_khash_mode_parallel)
+		{
+			pos = 0U;
+
+			if (state->position != 0U)
+			{
+				/* complete a buffered block */
+				blen = (inplen < SIAP_KHASH_BLOCK_SIZE - state->position) ? inplen : SIAP_KHASH_BLOCK_SIZE - state->position;
+				qsc_memutils_copy(state->buffer + state->position, input, blen);
+				state->position += blen;
+				pos = blen;
+
+				if (state->position == SIAP_KHASH_BLOCK_SIZE)
+				{
+					khash_parallel_blocks(lhash, state->buffer, SIAP_KHASH_BLOCK_SIZE, 0U, 1U);
+					siap_keccakx_stream_absorb(&state->sponge, lhash, SIAP_KHASH_LEAF_HASH_SIZE);
+					++state->bcount;
+					state->position = 0U;
+				}
+			}
+
+			/* hash full blocks directly from the input, one multi-buffer sweep at a time */
+			while (inplen - pos >= SIAP_KHASH_BLOCK_SIZE)
+			{
+				count = (inplen - pos) / SIAP_KHASH_BLOCK_SIZE;
+				count = (count < SIAP_KECCAKX_LANES_MAX) ? count : SIAP_KECCAKX_LANES_MAX;
+				khash_parallel_blocks(lhash, input + pos, count * SIAP_KHASH_BLOCK_SIZE, 0U, count);
+				siap_keccakx_stream_absorb(&state->sponge, lhash, count * SIAP_KHASH_LEAF_HASH_SIZE);
+				state->bcount += count;
+				pos += count * SIAP_KHASH_BLOCK_SIZE;
+			}
+
+			if (pos < inplen)
+			{
+				qsc_memutils_copy(state->buffer + state->position, input + pos, inplen - pos);
+				state->position += inplen - pos;
+			}
+
+			qsc_memutils_secure_erase(lhash, sizeof(lhash));
+		}
+		else
+		{
+			siap_keccakx_stream_absorb(&state->sponge, input, inplen);
+		}
+	}
+}
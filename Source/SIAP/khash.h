@@ -0,0 +1,243 @@
+/* 2025-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SIAP_KHASH_H
+#define SIAP_KHASH_H
+
+#include "siapcommon.h"
+#include "siap.h"
+#include "keccakx.h"
+
+/**
+* \file khash.h
+* \brief SIAP key tree hash functions.
+*
+* \details
+* Computes the device tag khash over the key tree in the mode recorded in the tag.
+* The serial mode is the original SHAKE hash of the whole tree.
+* The parallel mode is an SP 800-185 ParallelHash over fixed size blocks of the tree: each block is hashed independently
+* with SHAKE, using the multi-buffer Keccak engine, and the chained block hashes are absorbed by a cSHAKE instance
+* customized with the SIAP configuration string. The block hashes can also be divided between several threads with
+* \c siap_khash_parallel_compute; the threaded hash is not incremental, so a build that threads the device tag hash
+* hashes the whole tree before encryption instead of in the encryption pass.
+*
+* The Merkle mode hashes each token as a leaf, H(0x00 || token), and each interior node as H(0x01 || left || right).
+* The tag stores the root together with the authentication path of the current token. Because tokens are consumed
+* in order and erased, every left sibling of the next token is the root of an all-zero subtree, and only right siblings
+* that leave the old path are recomputed; moving the tag to the next token costs O(log n) hashes amortized, and
+* verifying the current token costs one path fold.
+*
+* The segment mode is used with segmented device keys; it does not hash the tokens, but commits to the mac
+* of the segment holding the current token, which authenticates that segment.
+*
+* The modes produce different hashes, so a tag can only be verified in the mode it was created in.
+*/
+
+/*!
+* \def SIAP_KHASH_BLOCK_SIZE
+* \brief The size in bytes of a ParallelHash key tree block.
+*/
+#define SIAP_KHASH_BLOCK_SIZE 1024U
+
+/*!
+* \def SIAP_KHASH_LEAF_HASH_SIZE
+* \brief The size in bytes of a chained block hash, twice the tag hash size.
+*/
+#define SIAP_KHASH_LEAF_HASH_SIZE (SIAP_KTAG_STATE_HASH * 2U)
+
+/*!
+* \def SIAP_KHASH_THREADS
+* \brief The number of threads used by the parallel mode of \c siap_khash_compute.
+*
+* \details A value of 1 hashes on the calling thread, which suits a server already running one authentication per core.
+* Larger values, set at build time, start threads for each device tag hash; see \c SIAP_KHASH_THREAD_BLOCKS.
+* Other callers pass their own thread count to \c siap_khash_parallel_compute.
+*/
+#if !defined(SIAP_KHASH_THREADS)
+#	define SIAP_KHASH_THREADS 1U
+#endif
+
+/*!
+* \def SIAP_KHASH_THREAD_BLOCKS
+* \brief The minimum number of blocks assigned to each worker thread.
+* The default key tree of 32 blocks (64 with extended encryption) is divided between two (four) threads.
+*/
+#define SIAP_KHASH_THREAD_BLOCKS 16U
+
+/*!
+ * \struct siap_khash_state
+ * \brief The incremental key tree hash state, for the serial and parallel modes.
+ */
+SIAP_EXPORT_API typedef struct siap_khash_state
+{
+	siap_keccakx_stream sponge;					/*!< The SHAKE sponge, or the ParallelHash outer cSHAKE sponge */
+	uint8_t buffer[SIAP_KHASH_BLOCK_SIZE];		/*!< The partial ParallelHash block */
+	size_t position;							/*!< The partial block length */
+	size_t bcount;								/*!< The number of ParallelHash blocks absorbed */
+	siap_khash_modes mode;						/*!< The key tree hash mode */
+} siap_khash_state;
+
+/**
+ * \brief Compute the key tree hash.
+ *
+ * \param output The output hash array of size \c SIAP_KTAG_STATE_HASH.
+ * \param input [const] The key tree.
+ * \param inplen The key tree length in bytes.
+ * \param mode The key tree hash mode.
+ *
+ * \return Returns true if the mode is recognized and the hash was computed.
+ */
+SIAP_EXPORT_API bool siap_khash_compute(uint8_t* output, const uint8_t* input, size_t inplen, siap_khash_modes mode);
+
+/**
+ * \brief Finalize an incremental key tree hash and erase the state.
+ *
+ * \param state A pointer to the key tree hash state.
+ * \param output The output hash array of size \c SIAP_KTAG_STATE_HASH.
+ */
+SIAP_EXPORT_API void siap_khash_finalize(siap_khash_state* state, uint8_t* output);
+
+/**
+ * \brief Initialize an incremental key tree hash.
+ * The Merkle mode is not incremental; use the Merkle functions for that mode.
+ *
+ * \param state A pointer to the key tree hash state.
+ * \param mode The key tree hash mode.
+ *
+ * \return Returns true if the mode should be hashed incrementally; false for the Merkle mode,
+ * and for the parallel mode when \c SIAP_KHASH_THREADS is more than one thread.
+ * The state is initialized for the serial and parallel modes in either case.
+ */
+SIAP_EXPORT_API bool siap_khash_initialize(siap_khash_state* state, siap_khash_modes mode);
+
+/**
+ * \brief Compute the device tag mac commitment: a cSHAKE of the encrypted key tree mac, customized with the kid.
+ *
+ * \param output The output hash array of size \c SIAP_KTAG_STATE_HASH.
+ * \param kid [const] The device key identity array of size \c SIAP_KID_SIZE.
+ * \param mac [const] The key tree mac array of size \c SIAP_MAC_SIZE.
+ */
+SIAP_EXPORT_API void siap_khash_mac_commit(uint8_t* output, const uint8_t* kid, const uint8_t* mac);
+
+/**
+ * \brief Move a Merkle root and authentication path to the next token.
+ * The token before \c leaf, and every token before it, must have been erased from the tree.
+ *
+ * \param root The Merkle root array of size \c SIAP_KTAG_STATE_HASH, updated in place.
+ * \param path The authentication path, \c depth hashes of size \c SIAP_KTAG_STATE_HASH, updated in place.
+ * \param tree [const] The key tree tokens.
+ * \param count The number of tokens in the tree, a power of two.
+ * \param leaf The index of the next token.
+ *
+ * \return Returns false if the token count is not a power of two or the leaf index is zero.
+ */
+SIAP_EXPORT_API bool siap_khash_merkle_advance(uint8_t* root, uint8_t* path, const uint8_t* tree, size_t count, size_t leaf);
+
+/**
+ * \brief Compute a Merkle root, and optionally the authentication path of one token.
+ *
+ * \param root The output root array of size \c SIAP_KTAG_STATE_HASH.
+ * \param path The output authentication path, log2(count) hashes of size \c SIAP_KTAG_STATE_HASH; can be NULL.
+ * The path is zeroed if the leaf index is outside the tree.
+ * \param tree [const] The key tree tokens.
+ * \param count The number of tokens in the tree, a power of two.
+ * \param leaf The index of the token whose path is returned.
+ *
+ * \return Returns false if the token count is not a power of two.
+ */
+SIAP_EXPORT_API bool siap_khash_merkle_compute(uint8_t* root, uint8_t* path, const uint8_t* tree, size_t count, size_t leaf);
+
+/**
+ * \brief Verify a token against a Merkle root and authentication path.
+ *
+ * \param root [const] The Merkle root array of size \c SIAP_KTAG_STATE_HASH.
+ * \param path [const] The authentication path of the token.
+ * \param token [const] The token array of size \c SIAP_AUTHENTICATION_TOKEN_SIZE.
+ * \param leaf The index of the token.
+ * \param depth The number of hashes in the path.
+ *
+ * \return Returns true if the folded path matches the root.
+ */
+SIAP_EXPORT_API bool siap_khash_merkle_verify(const uint8_t* root, const uint8_t* path, const uint8_t* token, size_t leaf, size_t depth);
+
+/**
+ * \brief Compute the ParallelHash key tree hash with an explicit thread count.
+ *
+ * \param output The output hash array of size \c SIAP_KTAG_STATE_HASH.
+ * \param input [const] The key tree.
+ * \param inplen The key tree length in bytes.
+ * \param threads The maximum number of threads; the calling thread is used when the tree is too small to divide,
+ * and hashes the blocks of any thread that could not be started.
+ */
+SIAP_EXPORT_API void siap_khash_parallel_compute(uint8_t* output, const uint8_t* input, size_t inplen, size_t threads);
+
+/**
+ * \brief Compute the segmented key commitment: a cSHAKE of the mac of a key segment, customized
+ * with the segment index and the counter value the segment was encrypted under.
+ *
+ * \param output The output hash array of size \c SIAP_KTAG_STATE_HASH.
+ * \param index The segment index.
+ * \param sequence The segment sequence number.
+ * \param mac [const] The segment mac array of size \c SIAP_MAC_SIZE.
+ */
+SIAP_EXPORT_API void siap_khash_segment_commit(uint8_t* output, uint32_t index, uint32_t sequence, const uint8_t* mac);
+
+/**
+ * \brief Absorb a part of the key tree into an incremental key tree hash.
+ * Parallel mode inputs that are a multiple of \c SIAP_KHASH_BLOCK_SIZE are hashed without buffering.
+ *
+ * \param state A pointer to the key tree hash state.
+ * \param input [const] The key tree segment.
+ * \param inplen The segment length in bytes.
+ */
+SIAP_EXPORT_API void siap_khash_update(siap_khash_state* state, const uint8_t* input, size_t inplen);
+
+#endif
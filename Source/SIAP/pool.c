@@ -0,0 +1,187 @@
+#include "pool.h"
+#include "memutils.h"
+
+static void* pool_cache_acquire(siap_device_cache* cache, siap_pool_objects otype)
+{
+	void* obj;
+	bool refill;
+
+	obj = NULL;
+
+	if (cache != NULL && cache->pool != NULL && cache->pool->otype == otype)
+	{
+		/* an empty cache is refilled from the shared pool a batch at a time */
+		refill = (cache->count == 0U);
+
+		while (refill == true && cache->count < SIAP_POOL_CACHE_BATCH)
+		{
+			obj = siap_arena_acquire(&cache->pool->arena);
+			refill = (obj != NULL);
+
+			if (refill == true)
+			{
+				cache->objects[cache->count] = obj;
+				++cache->count;
+			}
+		}
+
+		obj = NULL;
+
+		if (cache->count != 0U)
+		{
+			/* the most recently released object is still in this thread's cache */
+			--cache->count;
+			obj = cache->objects[cache->count];
+			cache->objects[cache->count] = NULL;
+		}
+	}
+
+	return obj;
+}
+
+static bool pool_initialize(siap_device_pool* pool, size_t osize, size_t count, siap_pool_objects otype, uint32_t capacity)
+{
+	bool res;
+
+	res = false;
+
+	if (pool != NULL && count != 0U)
+	{
+		res = siap_arena_initialize(&pool->arena, osize, count);
+		pool->otype = otype;
+		pool->kcapacity = capacity;
+	}
+
+	return res;
+}
+
+siap_device_object* siap_device_cache_acquire(siap_device_cache* cache)
+{
+	SIAP_ASSERT(cache != NULL);
+
+	return (siap_device_object*)pool_cache_acquire(cache, siap_pool_object_device);
+}
+
+void siap_device_cache_dispose(siap_device_cache* cache)
+{
+	if (cache != NULL)
+	{
+		if (cache->pool != NULL)
+		{
+			/* cached objects were erased when they were released */
+			for (size_t i = 0U; i < cache->count; ++i)
+			{
+				(void)siap_arena_release_erased(&cache->pool->arena, cache->objects[i]);
+			}
+		}
+
+		qsc_memutils_clear(cache, sizeof(siap_device_cache));
+	}
+}
+
+void siap_device_cache_initialize(siap_device_cache* cache, siap_device_pool* pool)
+{
+	SIAP_ASSERT(cache != NULL);
+	SIAP_ASSERT(pool != NULL);
+
+	if (cache != NULL)
+	{
+		qsc_memutils_clear(cache, sizeof(siap_device_cache));
+		cache->pool = pool;
+	}
+}
+
+void siap_device_cache_release(siap_device_cache* cache, void* object)
+{
+	SIAP_ASSERT(cache != NULL);
+
+	if (cache != NULL && cache->pool != NULL && object != NULL)
+	{
+		/* the object is erased here, once, the slot padding included */
+		qsc_memutils_secure_erase(object, cache->pool->arena.ssize);
+
+		/* a full cache returns its oldest objects to the shared pool */
+		if (cache->count == SIAP_POOL_CACHE_DEPTH)
+		{
+			for (size_t i = 0U; i < SIAP_POOL_CACHE_BATCH; ++i)
+			{
+				(void)siap_arena_release_erased(&cache->pool->arena, cache->objects[i]);
+			}
+
+			qsc_memutils_move(cache->objects, cache->objects + SIAP_POOL_CACHE_BATCH, (SIAP_POOL_CACHE_DEPTH - SIAP_POOL_CACHE_BATCH) * sizeof(void*));
+			cache->count -= SIAP_POOL_CACHE_BATCH;
+		}
+
+		cache->objects[cache->count] = object;
+		++cache->count;
+	}
+}
+
+void siap_device_pool_dispose(siap_device_pool* pool)
+{
+	if (pool != NULL)
+	{
+		siap_arena_dispose(&pool->arena);
+		pool->otype = siap_pool_object_device;
+		pool->kcapacity = 0U;
+	}
+}
+
+bool siap_device_pool_initialize(siap_device_pool* pool, size_t count)
+{
+	SIAP_ASSERT(pool != NULL);
+	SIAP_ASSERT(count != 0U);
+
+	return pool_initialize(pool, sizeof(siap_device_object), count, siap_pool_object_device, 0U);
+}
+
+siap_segmented_object* siap_segmented_cache_acquire(siap_device_cache* cache)
+{
+	SIAP_ASSERT(cache != NULL);
+
+	return (siap_segmented_object*)pool_cache_acquire(cache, siap_pool_object_segmented);
+}
+
+bool siap_segmented_pool_initialize(siap_device_pool* pool, size_t count)
+{
+	SIAP_ASSERT(pool != NULL);
+	SIAP_ASSERT(count != 0U);
+
+	return pool_initialize(pool, sizeof(siap_segmented_object), count, siap_pool_object_segmented, 0U);
+}
+
+siap_variable_object* siap_variable_cache_acquire(siap_device_cache* cache)
+{
+	SIAP_ASSERT(cache != NULL);
+
+	siap_variable_object* obj;
+
+	obj = (siap_variable_object*)pool_cache_acquire(cache, siap_pool_object_variable);
+
+	if (obj != NULL)
+	{
+		obj->kcapacity = cache->pool->kcapacity;
+	}
+
+	return obj;
+}
+
+bool siap_variable_pool_initialize(siap_device_pool* pool, size_t count, uint32_t capacity)
+{
+	SIAP_ASSERT(pool != NULL);
+	SIAP_ASSERT(count != 0U);
+
+	size_t osize;
+	bool res;
+
+	res = false;
+
+	if (capacity >= SIAP_KTREE_COUNT_MIN && capacity <= SIAP_KTREE_COUNT_MAX && (capacity & (capacity - 1U)) == 0U)
+	{
+		/* the key tree and its mac follow the object header in the same slot */
+		osize = sizeof(siap_variable_object) + ((size_t)capacity * SIAP_AUTHENTICATION_TOKEN_SIZE) + SIAP_MAC_SIZE;
+		res = pool_initialize(pool, osize, count, siap_pool_object_variable, capacity);
+	}
+
+	return res;
+}
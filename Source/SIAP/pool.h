@@ -0,0 +1,249 @@
+/* 2025-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SIAP_POOL_H
+#define SIAP_POOL_H
+
+#include "siapcommon.h"
+#include "arena.h"
+#include "siap.h"
+
+/**
+* \file pool.h
+* \brief SIAP device key and tag object pool.
+*
+* \details
+* A server that loads a device key and tag for every request takes them from a pool instead of the heap or the stack.
+* A pool holds one kind of object: fixed device keys, segmented device keys, or variable-size device keys whose key tree,
+* up to the pool capacity, is held in the object itself, so no key tree is allocated either.
+* The pool objects are slots of a secure arena, so they are cache-line aligned, locked in memory, and allocated once.
+* Each thread takes and returns objects through its own cache, which needs no lock; the cache only goes to the shared
+* pool when it is empty or full, a batch of objects at a time. A released object is erased by the releasing thread
+* and is the next one that thread takes, so steady-state authentication reuses warm memory and never allocates.
+* An object is erased once, when it is released; it is not erased again when the cache returns it to the shared pool.
+*/
+
+/*!
+* \def SIAP_POOL_CACHE_DEPTH
+* \brief The number of objects a thread cache can hold.
+*/
+#define SIAP_POOL_CACHE_DEPTH 16U
+
+/*!
+* \def SIAP_POOL_CACHE_BATCH
+* \brief The number of objects moved between a thread cache and the shared pool at a time.
+*/
+#define SIAP_POOL_CACHE_BATCH 8U
+
+/*!
+ * \enum siap_pool_objects
+ * \brief The kind of object a pool holds.
+ */
+SIAP_EXPORT_API typedef enum siap_pool_objects
+{
+	siap_pool_object_device = 0x00U,			/*!< A fixed device key and tag */
+	siap_pool_object_segmented = 0x01U,			/*!< A segmented device key and tag */
+	siap_pool_object_variable = 0x02U			/*!< A variable-size device key, its key tree, and tag */
+} siap_pool_objects;
+
+/*!
+ * \struct siap_device_object
+ * \brief A pooled device key and its tag.
+ */
+SIAP_EXPORT_API typedef struct siap_device_object
+{
+	siap_device_key dkey;						/*!< The device key */
+	siap_device_tag dtag;						/*!< The device tag */
+} siap_device_object;
+
+/*!
+ * \struct siap_segmented_object
+ * \brief A pooled segmented device key and its tag.
+ */
+SIAP_EXPORT_API typedef struct siap_segmented_object
+{
+	siap_segmented_key dkey;					/*!< The segmented device key */
+	siap_device_tag dtag;						/*!< The device tag */
+} siap_segmented_object;
+
+/*!
+ * \struct siap_variable_object
+ * \brief A pooled variable-size device key, its tag, and the key tree buffer.
+ * The key is loaded with \c siap_deserialize_variable_key_buffer on the \c ktree member and the \c kcapacity count,
+ * and must not be released with \c siap_variable_key_dispose.
+ */
+SIAP_EXPORT_API typedef struct siap_variable_object
+{
+	siap_variable_key vkey;						/*!< The variable-size device key */
+	siap_device_tag dtag;						/*!< The device tag */
+	uint32_t kcapacity;							/*!< The number of tokens the key tree buffer can hold */
+	uint8_t ktree[];							/*!< The key tree buffer, followed by room for the mac */
+} siap_variable_object;
+
+/*!
+ * \struct siap_device_pool
+ * \brief The shared device object pool.
+ */
+SIAP_EXPORT_API typedef struct siap_device_pool
+{
+	siap_secure_arena arena;					/*!< The arena holding the objects */
+	siap_pool_objects otype;					/*!< The kind of object the pool holds */
+	uint32_t kcapacity;							/*!< The key tree capacity of a variable-size key object, in tokens */
+} siap_device_pool;
+
+/*!
+ * \struct siap_device_cache
+ * \brief A thread's device object cache; used by one thread only.
+ */
+SIAP_EXPORT_API typedef struct siap_device_cache
+{
+	void* objects[SIAP_POOL_CACHE_DEPTH];		/*!< The cached objects, the most recently released last */
+	siap_device_pool* pool;						/*!< The shared pool */
+	size_t count;								/*!< The number of cached objects */
+} siap_device_cache;
+
+/**
+ * \brief Take a device object.
+ * The object is zeroed.
+ *
+ * \param cache A pointer to the calling thread's cache.
+ *
+ * \return Returns the object, or NULL if the pool is exhausted or does not hold fixed device keys.
+ */
+SIAP_EXPORT_API siap_device_object* siap_device_cache_acquire(siap_device_cache* cache);
+
+/**
+ * \brief Return every cached object to the shared pool.
+ * Called by the owning thread before it exits.
+ *
+ * \param cache A pointer to the cache.
+ */
+SIAP_EXPORT_API void siap_device_cache_dispose(siap_device_cache* cache);
+
+/**
+ * \brief Initialize a thread cache on a shared pool.
+ *
+ * \param cache A pointer to the cache.
+ * \param pool A pointer to the shared pool.
+ */
+SIAP_EXPORT_API void siap_device_cache_initialize(siap_device_cache* cache, siap_device_pool* pool);
+
+/**
+ * \brief Erase a pooled object of any kind and return it to the thread cache.
+ * An object may be released through the cache of a thread other than the one that took it, on the same pool.
+ *
+ * \param cache A pointer to the calling thread's cache.
+ * \param object A pointer to the object, may be NULL.
+ */
+SIAP_EXPORT_API void siap_device_cache_release(siap_device_cache* cache, void* object);
+
+/**
+ * \brief Erase and release the shared pool.
+ * Every thread cache must have been disposed.
+ *
+ * \param pool A pointer to the pool.
+ */
+SIAP_EXPORT_API void siap_device_pool_dispose(siap_device_pool* pool);
+
+/**
+ * \brief Initialize the shared pool.
+ * The objects are allocated once, locked in memory where the system allows it, see \c siap_arena_initialize.
+ *
+ * \param pool A pointer to the pool.
+ * \param count The number of objects.
+ *
+ * \return Returns false if the objects could not be allocated.
+ */
+SIAP_EXPORT_API bool siap_device_pool_initialize(siap_device_pool* pool, size_t count);
+
+/**
+ * \brief Take a segmented device key object.
+ * The object is zeroed.
+ *
+ * \param cache A pointer to the calling thread's cache.
+ *
+ * \return Returns the object, or NULL if the pool is exhausted or does not hold segmented device keys.
+ */
+SIAP_EXPORT_API siap_segmented_object* siap_segmented_cache_acquire(siap_device_cache* cache);
+
+/**
+ * \brief Initialize a shared pool of segmented device key objects.
+ *
+ * \param pool A pointer to the pool.
+ * \param count The number of objects.
+ *
+ * \return Returns false if the objects could not be allocated.
+ */
+SIAP_EXPORT_API bool siap_segmented_pool_initialize(siap_device_pool* pool, size_t count);
+
+/**
+ * \brief Take a variable-size device key object.
+ * The object is zeroed, and its \c kcapacity member set to the pool capacity.
+ *
+ * \param cache A pointer to the calling thread's cache.
+ *
+ * \return Returns the object, or NULL if the pool is exhausted or does not hold variable-size device keys.
+ */
+SIAP_EXPORT_API siap_variable_object* siap_variable_cache_acquire(siap_device_cache* cache);
+
+/**
+ * \brief Initialize a shared pool of variable-size device key objects.
+ * Every object holds a key tree of up to \c capacity tokens.
+ *
+ * \param pool A pointer to the pool.
+ * \param count The number of objects.
+ * \param capacity The key tree capacity, a power of two between \c SIAP_KTREE_COUNT_MIN and \c SIAP_KTREE_COUNT_MAX.
+ *
+ * \return Returns false if the capacity is not supported or the objects could not be allocated.
+ */
+SIAP_EXPORT_API bool siap_variable_pool_initialize(siap_device_pool* pool, size_t count, uint32_t capacity);
+
+#endif
@@ -0,0 +1,106 @@
+#include "profile.h"
+#include "memutils.h"
+#include "stringutils.h"
+
+/* the profile parameters all scale with the profile security size */
+#define PROFILE_CONFIG_REVISION_SIZE 4U
+#define PROFILE_DEVICE_KEY_SIZE(s) (((s) * SIAP_KTREE_COUNT) + (s) + SIAP_KID_SIZE + SIAP_EXPIRATION_SIZE)
+#define PROFILE_SERVER_KEY_SIZE(s) ((s) + SIAP_SID_SIZE + (s) + SIAP_EXPIRATION_SIZE)
+
+static const siap_profile PROFILE_TABLE[SIAP_PROFILE_COUNT] =
+{
+	{
+		.config = "siap-rcs256-keccak256",
+		.devicekey = PROFILE_DEVICE_KEY_SIZE(32U),
+		.hashsize = 32U,
+		.macsize = 32U,
+		.serverkey = PROFILE_SERVER_KEY_SIZE(32U),
+		.tokensize = 32U,
+		.rate = qsc_keccak_rate_256,
+		.id = siap_profile_256
+	},
+	{
+		.config = "siap-rcs512-keccak512",
+		.devicekey = PROFILE_DEVICE_KEY_SIZE(64U),
+		.hashsize = 64U,
+		.macsize = 64U,
+		.serverkey = PROFILE_SERVER_KEY_SIZE(64U),
+		.tokensize = 64U,
+		.rate = qsc_keccak_rate_512,
+		.id = siap_profile_512
+	}
+};
+
+const siap_profile* siap_profile_from_device_key_size(size_t size)
+{
+	const siap_profile* prof;
+
+	prof = NULL;
+
+	for (size_t i = 0U; i < SIAP_PROFILE_COUNT; ++i)
+	{
+		if (PROFILE_TABLE[i].devicekey == size)
+		{
+			prof = &PROFILE_TABLE[i];
+			break;
+		}
+	}
+
+	return prof;
+}
+
+const siap_profile* siap_profile_from_config(const char* config, size_t length)
+{
+	SIAP_ASSERT(config != NULL);
+
+	const siap_profile* prof;
+	size_t clen;
+
+	prof = NULL;
+
+	if (config != NULL && length > PROFILE_CONFIG_REVISION_SIZE)
+	{
+		/* skip the revision prefix, and any terminating zeroes */
+		clen = length - PROFILE_CONFIG_REVISION_SIZE;
+
+		while (clen > 0U && config[PROFILE_CONFIG_REVISION_SIZE + clen - 1U] == '\0')
+		{
+			--clen;
+		}
+
+		for (size_t i = 0U; i < SIAP_PROFILE_COUNT; ++i)
+		{
+			if (clen == qsc_stringutils_string_size(PROFILE_TABLE[i].config) &&
+				qsc_memutils_are_equal((const uint8_t*)config + PROFILE_CONFIG_REVISION_SIZE, (const uint8_t*)PROFILE_TABLE[i].config, clen) == true)
+			{
+				prof = &PROFILE_TABLE[i];
+				break;
+			}
+		}
+	}
+
+	return prof;
+}
+
+const siap_profile* siap_profile_get(siap_profile_ids id)
+{
+	const siap_profile* prof;
+
+	prof = NULL;
+
+	if (id == siap_profile_256 || id == siap_profile_512)
+	{
+		prof = &PROFILE_TABLE[(size_t)id - 1U];
+	}
+
+	return prof;
+}
+
+const siap_profile* siap_profile_native(void)
+{
+#if defined(SIAP_EXTENDED_ENCRYPTION)
+	return &PROFILE_TABLE[1U];
+#else
+	return &PROFILE_TABLE[0U];
+#endif
+}
@@ -0,0 +1,141 @@
+/* 2025-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SIAP_PROFILE_H
+#define SIAP_PROFILE_H
+
+#include "siapcommon.h"
+#include "siap.h"
+#include "sha3.h"
+
+/**
+* \file profile.h
+* \brief SIAP security profile check.
+*
+* \details
+* Describes the 256-bit and 512-bit SIAP security profiles: the configuration string, the Keccak rate,
+* and the parameter and serialized structure sizes of each profile.
+* The library structures and hash functions are fixed at compile time by \c SIAP_EXTENDED_ENCRYPTION, so a library
+* instance only processes cards of its native profile; serving both profiles still takes one server build per profile.
+* These functions do not dispatch between profiles. They let a server check which profile a card or configuration
+* string belongs to before parsing it, and refuse a card it would otherwise read with the wrong structure sizes.
+*/
+
+/*!
+* \def SIAP_PROFILE_COUNT
+* \brief The number of security profiles.
+*/
+#define SIAP_PROFILE_COUNT 2U
+
+/*!
+ * \enum siap_profile_ids
+ * \brief The SIAP security profile identifiers.
+ */
+SIAP_EXPORT_API typedef enum siap_profile_ids
+{
+	siap_profile_none = 0x00U,					/*!< No profile is selected */
+	siap_profile_256 = 0x01U,					/*!< The 256-bit profile, RCS-256 and Keccak-256 */
+	siap_profile_512 = 0x02U					/*!< The 512-bit profile, RCS-512 and Keccak-512 */
+} siap_profile_ids;
+
+/*!
+ * \struct siap_profile
+ * \brief A SIAP security profile description.
+ */
+SIAP_EXPORT_API typedef struct siap_profile
+{
+	const char* config;							/*!< The configuration string, without the revision prefix */
+	size_t devicekey;							/*!< The serialized device key size */
+	size_t hashsize;							/*!< The passphrase and key tree hash size */
+	size_t macsize;								/*!< The cipher mac size */
+	size_t serverkey;							/*!< The serialized server key size */
+	size_t tokensize;							/*!< The authentication token size */
+	qsc_keccak_rate rate;						/*!< The Keccak rate */
+	siap_profile_ids id;						/*!< The profile identifier */
+} siap_profile;
+
+/**
+ * \brief Get the profile matching a serialized device key size.
+ *
+ * \param size The serialized device key size in bytes.
+ *
+ * \return Returns the profile, or NULL if the size does not match a profile.
+ */
+SIAP_EXPORT_API const siap_profile* siap_profile_from_device_key_size(size_t size);
+
+/**
+ * \brief Get the profile matching a configuration string.
+ * The revision prefix is ignored, so every revision of a profile matches it.
+ *
+ * \param config [const] The configuration string.
+ * \param length The configuration string length.
+ *
+ * \return Returns the profile, or NULL if the string does not match a profile.
+ */
+SIAP_EXPORT_API const siap_profile* siap_profile_from_config(const char* config, size_t length);
+
+/**
+ * \brief Get a profile by identifier.
+ *
+ * \param id The profile identifier.
+ *
+ * \return Returns the profile, or NULL if the identifier is unknown.
+ */
+SIAP_EXPORT_API const siap_profile* siap_profile_get(siap_profile_ids id);
+
+/**
+ * \brief Get the profile the library was built for.
+ *
+ * \return Returns the native profile.
+ */
+SIAP_EXPORT_API const siap_profile* siap_profile_native(void);
+
+#endif
@@ -1,4 +1,7 @@
 #include "server.h"
+#include "affinity.h"
+#include "keccakx.h"
+#include "khash.h"
 #include "acp.h"
 #include "async.h"
 #include "encoding.h"
@@ -9,116 +12,841 @@
 #include "sha3.h"
 #include "stringutils.h"
 #include "timestamp.h"
+#include <time.h>
+
+#if defined(SIAP_EXTENDED_ENCRYPTION)
+#	define SERVER_KECCAK_RATE qsc_keccak_rate_512
+#else
+#	define SERVER_KECCAK_RATE qsc_keccak_rate_256
+#endif
+
+/* the fused hash and encryption pass works through the key tree in chunks of this size */
+#define SERVER_FUSED_CHUNK_SIZE (4U * SIAP_KHASH_BLOCK_SIZE)
+
+/* the mac commitment tag mode is only accepted by the commitment protocol revision */
+#if defined(SIAP_TAG_COMMITMENT)
+#	define SERVER_TAG_COMMITTED(dtag) ((dtag)->kmode == siap_khash_mode_commitment)
+#else
+#	define SERVER_TAG_COMMITTED(dtag) (false)
+#endif
+
+/* the session ticket mac and ticket key customization strings */
+#define SERVER_TICKET_CUSTOM "siap-session-ticket"
+#define SERVER_TICKET_KEY_CUSTOM "siap-session-ticket-key"
+
+#define SERVER_BATCH_THREADS_MAX 64U
+#define SERVER_CALIBRATE_SAMPLES_MAX 128U
+
+typedef struct server_passphrase_task
+{
+	uint8_t* phashes;
+	const char* const* passphrases;
+	const size_t* passlens;
+	size_t count;
+	size_t cpucost;
+	size_t first;
+	size_t memcost;
+	size_t stride;
+	bool res;
+} server_passphrase_task;
+
+typedef struct server_key_tree
+{
+	uint8_t* ktree;
+	uint8_t* kid;
+	const uint8_t* info;
+	size_t infolen;
+	size_t count;
+	uint64_t expiration;
+} server_key_tree;
+
+static void server_derive_cipher_key(uint8_t* output, size_t outlen, siap_cshake_encoded* cenc, const siap_server_prepared_key* pkey, const uint8_t* kid, const uint8_t* phash)
+{
+	/* key hash is: passphrase-hash + device-id + counter + server-salt: k = H(ph, did/kidx++, s) */
+	qsc_memutils_copy(cenc, &pkey->kcipher, sizeof(siap_cshake_encoded));
+	qsc_memutils_copy(cenc->message + cenc->namepos, kid, SIAP_KID_SIZE);
+	qsc_memutils_copy(cenc->message + cenc->keypos, phash, SIAP_HASH_SIZE);
+	siap_keccakx_cshake_compute(output, outlen, cenc);
+}
+
+static void server_derive_token(uint8_t* token, siap_cshake_encoded* tenc, const siap_server_prepared_key* pkey, const uint8_t* kid)
+{
+	/* token hash is: server-key + config + device-id + counter: t = H(k, c, did/kidx) */
+	qsc_memutils_copy(tenc, &pkey->ktoken, sizeof(siap_cshake_encoded));
+	qsc_memutils_copy(tenc->message + tenc->custpos, kid, SIAP_KID_SIZE);
+	siap_keccakx_cshake_compute(token, SIAP_AUTHENTICATION_TOKEN_SIZE, tenc);
+}
+
+static void server_generate_tokens(uint8_t* output, const siap_server_prepared_key* pkey, const uint8_t* did, uint32_t kctr, size_t count)
+{
+	uint8_t lmsg[SIAP_KECCAKX_LANES_MAX][SIAP_KECCAKX_MESSAGE_MAX] = { 0U };
+	const uint8_t* pmsg[SIAP_KECCAKX_LANES_MAX] = { 0 };
+	uint8_t* ptok[SIAP_KECCAKX_LANES_MAX] = { 0 };
+	size_t lcnt;
+
+	/* the incrementing kid/kidx in custom param creates a keccak counter-mode generator;
+	   the prepared input is copied to each lane, only the kid is rewritten for each leaf,
+	   and the leaves are hashed in parallel lanes */
+	for (size_t i = 0U; i < count; i += lcnt)
+	{
+		lcnt = (count - i < SIAP_KECCAKX_LANES_MAX) ? count - i : SIAP_KECCAKX_LANES_MAX;
+
+		for (size_t j = 0U; j < lcnt; ++j)
+		{
+			qsc_memutils_copy(lmsg[j], pkey->ktoken.message, pkey->ktoken.msglen);
+			qsc_memutils_copy(lmsg[j] + pkey->ktoken.custpos, did, SIAP_DID_SIZE);
+			qsc_intutils_be32to8(lmsg[j] + pkey->ktoken.custpos + SIAP_DID_SIZE, kctr);
+			pmsg[j] = lmsg[j];
+			ptok[j] = output + ((i + j) * SIAP_AUTHENTICATION_TOKEN_SIZE);
+			++kctr;
+		}
+
+		siap_keccakx_compute(ptok, SIAP_AUTHENTICATION_TOKEN_SIZE, pmsg, pkey->ktoken.msglen, pkey->ktoken.rate, pkey->ktoken.domain, lcnt);
+	}
+
+	/* cleanup */
+	qsc_memutils_secure_erase(lmsg, sizeof(lmsg));
+}
+
+static void server_cipher_initialize(siap_server_scratch* scratch, const siap_server_prepared_key* pkey, const uint8_t* kid, const uint8_t* phash, const uint8_t* info, size_t infolen, bool encryption)
+{
+	/* using kid as the name param with the incrementing kidx ensures key/nonce uniqueness every encryption cycle */
+	server_derive_cipher_key(scratch->ckey, sizeof(scratch->ckey), &scratch->cenc, pkey, kid, phash);
+
+	qsc_rcs_keyparams kp = { .info = info, .infolen = infolen, .key = scratch->ckey, .keylen = SIAP_SERVER_KEY_SIZE, .nonce = scratch->ckey + SIAP_SERVER_KEY_SIZE };
+
+	/* initialize the cipher, the key is erased with the scratch workspace */
+	qsc_rcs_initialize(&scratch->rstate, &kp, encryption);
+}
+
+static void server_fused_encrypt(const server_key_tree* tree, siap_khash_state* kstate, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch)
+{
+	size_t clen;
+	size_t tsize;
+
+	server_cipher_initialize(scratch, pkey, tree->kid, phash, tree->info, tree->infolen, true);
+	tsize = tree->count * SIAP_AUTHENTICATION_TOKEN_SIZE;
+
+	/* hash each plaintext chunk and encrypt it in place, the mac is appended to the ktree array */
+	for (size_t pos = 0U; pos < tsize; pos += clen)
+	{
+		clen = (tsize - pos < SERVER_FUSED_CHUNK_SIZE) ? tsize - pos : SERVER_FUSED_CHUNK_SIZE;
+
+		if (kstate != NULL)
+		{
+			siap_khash_update(kstate, tree->ktree + pos, clen);
+		}
+
+		(void)qsc_rcs_extended_transform(&scratch->rstate, tree->ktree + pos, tree->ktree + pos, clen, (pos + clen == tsize));
+	}
+
+	qsc_rcs_dispose(&scratch->rstate);
+}
+
+static bool server_passphrase_hash(uint8_t* phash, const char* passphrase, size_t passlen, size_t cpucost, size_t memcost, qsc_scb_state* sscb)
+{
+	bool res;
+
+	res = false;
+
+	/* the costs come from the device tag, an out of range cost is refused rather than paid for */
+	if (cpucost <= SIAP_SCB_CPU_COST_MAX && memcost <= SIAP_SCB_MEMORY_COST_MAX)
+	{
+		/* a zero cost is the compiled default, so tags that do not record costs keep the original hash */
+		cpucost = (cpucost != 0U) ? cpucost : SIAP_SCB_CPU_COST;
+		memcost = (memcost != 0U) ? memcost : SIAP_SCB_MEMORY_COST;
+
+		/* QSC allocates the memory-hard cache here and frees it on dispose, the state is erased */
+		qsc_scb_initialize(sscb, (uint8_t*)passphrase, passlen, NULL, 0U, cpucost, memcost);
+		qsc_scb_generate(sscb, phash, SIAP_HASH_SIZE);
+		qsc_scb_dispose(sscb);
+		res = true;
+	}
+
+	return res;
+}
+
+static void server_passphrase_worker(void* state)
+{
+	server_passphrase_task* task;
+
+	task = (server_passphrase_task*)state;
+
+	task->res = true;
+
+	/* each worker takes every stride'th passphrase, the SCB cost of every passphrase is the same */
+	for (size_t i = task->first; i < task->count; i += task->stride)
+	{
+		if (siap_server_passphrase_hash_generate_costs(task->phashes + (i * SIAP_HASH_SIZE), task->passphrases[i], task->passlens[i], task->cpucost, task->memcost) == false)
+		{
+			task->res = false;
+			break;
+		}
+	}
+}
+
+static uint64_t server_scb_latency(size_t cpucost, size_t memcost, size_t samples)
+{
+	uint64_t times[SERVER_CALIBRATE_SAMPLES_MAX] = { 0U };
+	uint8_t tmph[SIAP_HASH_SIZE] = { 0U };
+	const char pass[SIAP_HASH_SIZE] = { 0 };
+	struct timespec ts1;
+	struct timespec ts2;
+	uint64_t tmp;
+	size_t j;
+
+	for (size_t i = 0U; i < samples; ++i)
+	{
+		(void)timespec_get(&ts1, TIME_UTC);
+		(void)siap_server_passphrase_hash_generate_costs(tmph, pass, sizeof(pass), cpucost, memcost);
+		(void)timespec_get(&ts2, TIME_UTC);
+
+		/* elapsed microseconds, inserted in ascending order */
+		tmp = ((uint64_t)(ts2.tv_sec - ts1.tv_sec) * 1000000ULL) + (uint64_t)((ts2.tv_nsec - ts1.tv_nsec) / 1000L);
+
+		for (j = i; j > 0U && times[j - 1U] > tmp; --j)
+		{
+			times[j] = times[j - 1U];
+		}
+
+		times[j] = tmp;
+	}
+
+	qsc_memutils_clear(tmph, sizeof(tmph));
+
+	/* the 99th percentile sample */
+	return times[(((samples * 99U) + 99U) / 100U) - 1U];
+}
+
+static void server_segment_cipher_initialize(siap_server_scratch* scratch, const siap_segmented_key* dkey, size_t index, uint32_t sequence, const siap_server_prepared_key* pkey, const uint8_t* phash, bool encryption)
+{
+	uint8_t ad[SIAP_CARD_FORMAT_SIZE + SIAP_DID_SIZE + SIAP_EXPIRATION_SIZE] = { 0U };
+	uint8_t info[sizeof(uint32_t)] = { 0U };
+	uint8_t skid[SIAP_KID_SIZE] = { 0U };
+
+	/* the segment key is derived from the did and the counter value the segment is encrypted under,
+	   and the segment index is used as the cipher info tweak, so every key/nonce is used once */
+	qsc_memutils_copy(skid, dkey->kid, SIAP_DID_SIZE);
+	qsc_intutils_be32to8(skid + SIAP_DID_SIZE, sequence);
+	qsc_intutils_be32to8(info, (uint32_t)index);
+	server_cipher_initialize(scratch, pkey, skid, phash, info, sizeof(info), encryption);
+
+	/* bind the segment to the header fields that never change */
+	ad[0U] = (uint8_t)siap_card_format_segmented;
+	qsc_memutils_copy(ad + SIAP_CARD_FORMAT_SIZE, dkey->kid, SIAP_DID_SIZE);
+	qsc_intutils_le64to8(ad + SIAP_CARD_FORMAT_SIZE + SIAP_DID_SIZE, dkey->expiration);
+	qsc_rcs_set_associated(&scratch->rstate, ad, sizeof(ad));
+}
+
+static void server_segment_commit(siap_device_tag* dtag, const siap_segmented_key* dkey)
+{
+	const siap_key_segment* seg;
+	size_t sidx;
+
+	/* commit to the segment that holds the next token */
+	sidx = (size_t)qsc_intutils_be8to32(dkey->kid + SIAP_DID_SIZE) / SIAP_KSEGMENT_TOKENS;
+	sidx = (sidx < SIAP_KSEGMENT_COUNT) ? sidx : SIAP_KSEGMENT_COUNT - 1U;
+	seg = &dkey->segments[sidx];
+	siap_khash_segment_commit(dtag->khash, (uint32_t)sidx, seg->sequence, seg->stree + SIAP_KSEGMENT_SIZE);
+}
+
+static bool server_segment_decrypt(siap_segmented_key* dkey, size_t index, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch)
+{
+	siap_key_segment* seg;
+	bool res;
+
+	seg = &dkey->segments[index];
+	server_segment_cipher_initialize(scratch, dkey, index, seg->sequence, pkey, phash, false);
+	res = qsc_rcs_transform(&scratch->rstate, seg->stree, seg->stree, SIAP_KSEGMENT_SIZE);
+	qsc_rcs_dispose(&scratch->rstate);
+
+	return res;
+}
+
+static void server_segment_encrypt(siap_segmented_key* dkey, size_t index, uint32_t sequence, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch)
+{
+	siap_key_segment* seg;
+
+	seg = &dkey->segments[index];
+	seg->sequence = sequence;
+	server_segment_cipher_initialize(scratch, dkey, index, sequence, pkey, phash, true);
+	(void)qsc_rcs_transform(&scratch->rstate, seg->stree, seg->stree, SIAP_KSEGMENT_SIZE);
+	qsc_rcs_dispose(&scratch->rstate);
+}
+
+static siap_errors server_screen_device(const uint8_t* kid, uint64_t expiration, const siap_device_tag* dtag, const siap_server_prepared_key* pkey)
+{
+	uint64_t tnow;
+	siap_errors err;
+
+	/* start by comparing the device kid with the tag kid, and refuse a tag asking for an out of range passphrase cost */
+	if (dtag->cpucost > SIAP_SCB_CPU_COST_MAX || dtag->memcost > SIAP_SCB_MEMORY_COST_MAX)
+	{
+		err = siap_error_invalid_input;
+	}
+	else if (qsc_memutils_are_equal(kid, dtag->kid, SIAP_KID_SIZE) == true)
+	{
+		tnow = qsc_timestamp_epochtime_seconds();
+
+		/* check for a valid expiration time */
+		if (expiration <= pkey->skey.expiration &&
+			expiration > tnow &&
+			expiration <= (qsc_timestamp_epochtime_seconds() + SIAP_KEY_DURATION_SECONDS))
+		{
+			err = siap_error_none;
+		}
+		else
+		{
+			err = siap_error_key_expired;
+		}
+	}
+	else
+	{
+		err = siap_error_identity_mismatch;
+	}
+
+	return err;
+}
+
+static siap_errors server_verify_device(const uint8_t* kid, uint64_t expiration, const siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash)
+{
+	siap_errors err;
+
+	err = server_screen_device(kid, expiration, dtag, pkey);
+
+	/* verify the passphrase hash */
+	if (err == siap_error_none && qsc_intutils_verify(dtag->phash, phash, SIAP_HASH_SIZE) != 0U)
+	{
+		err = siap_error_passphrase_unrecognized;
+	}
+
+	return err;
+}
+
+static void server_ticket_mac(uint8_t* mac, const siap_session_ticket* ticket, const uint8_t* token, const siap_server_prepared_key* pkey)
+{
+	uint8_t tcust[SIAP_AUTHENTICATION_TOKEN_SIZE + SIAP_KID_SIZE] = { 0U };
+	uint8_t tkey[SIAP_AUTHENTICATION_TOKEN_SIZE] = { 0U };
+	uint8_t tmsg[SIAP_KID_SIZE + SIAP_EXPIRATION_SIZE + SIAP_EXPIRATION_SIZE] = { 0U };
+
+	/* the ticket key needs the server secret as well as the token, so a token holder cannot mint a ticket:
+	   k = cSHAKE(kbase, label, t || kid) */
+	qsc_memutils_copy(tcust, token, SIAP_AUTHENTICATION_TOKEN_SIZE);
+	qsc_memutils_copy(tcust + SIAP_AUTHENTICATION_TOKEN_SIZE, ticket->kid, SIAP_KID_SIZE);
+
+	/* the mac covers the kid, the issue time, and the expiration: m = KMAC(k, kid || iss || exp) */
+	qsc_memutils_copy(tmsg, ticket->kid, SIAP_KID_SIZE);
+	qsc_intutils_le64to8(tmsg + SIAP_KID_SIZE, ticket->issued);
+	qsc_intutils_le64to8(tmsg + SIAP_KID_SIZE + SIAP_EXPIRATION_SIZE, ticket->expiration);
+
+#if defined(SIAP_EXTENDED_ENCRYPTION)
+	qsc_cshake512_compute(tkey, sizeof(tkey), pkey->skey.kbase, SIAP_SERVER_KEY_SIZE, (const uint8_t*)SERVER_TICKET_KEY_CUSTOM, sizeof(SERVER_TICKET_KEY_CUSTOM) - 1U, tcust, sizeof(tcust));
+	qsc_kmac512_compute(mac, SIAP_MAC_SIZE, tmsg, sizeof(tmsg), tkey, sizeof(tkey), (const uint8_t*)SERVER_TICKET_CUSTOM, sizeof(SERVER_TICKET_CUSTOM) - 1U);
+#else
+	qsc_cshake256_compute(tkey, sizeof(tkey), pkey->skey.kbase, SIAP_SERVER_KEY_SIZE, (const uint8_t*)SERVER_TICKET_KEY_CUSTOM, sizeof(SERVER_TICKET_KEY_CUSTOM) - 1U, tcust, sizeof(tcust));
+	qsc_kmac256_compute(mac, SIAP_MAC_SIZE, tmsg, sizeof(tmsg), tkey, sizeof(tkey), (const uint8_t*)SERVER_TICKET_CUSTOM, sizeof(SERVER_TICKET_CUSTOM) - 1U);
+#endif
+
+	qsc_memutils_secure_erase(tcust, sizeof(tcust));
+	qsc_memutils_secure_erase(tkey, sizeof(tkey));
+}
+
+static size_t server_tree_depth(size_t count)
+{
+	size_t n;
+
+	n = 0U;
+
+	while ((count >> n) > 1U)
+	{
+		++n;
+	}
+
+	return n;
+}
+
+static void server_tree_device(server_key_tree* tree, const siap_device_key* dkey)
+{
+	/* the functions taking a const device key only read through the tree */
+	tree->ktree = (uint8_t*)dkey->ktree;
+	tree->kid = (uint8_t*)dkey->kid;
+	tree->info = NULL;
+	tree->infolen = 0U;
+	tree->count = SIAP_KTREE_COUNT;
+	tree->expiration = dkey->expiration;
+}
+
+static bool server_tree_extract(uint8_t* token, const server_key_tree* tree)
+{
+	uint32_t kidx;
+	bool res;
+
+	res = false;
+
+	/* get the current key index and key pointer */
+	kidx = qsc_intutils_be8to32(tree->kid + SIAP_DID_SIZE);
+
+	if (kidx < tree->count)
+	{
+		/* copy the token and clear it from the tree */
+		qsc_memutils_copy(token, tree->ktree + (kidx * SIAP_AUTHENTICATION_TOKEN_SIZE), SIAP_AUTHENTICATION_TOKEN_SIZE);
+		qsc_memutils_secure_erase(tree->ktree + (kidx * SIAP_AUTHENTICATION_TOKEN_SIZE), SIAP_AUTHENTICATION_TOKEN_SIZE);
+		/* increment the kid counter */
+		qsc_intutils_be8increment(tree->kid + SIAP_DID_SIZE, SIAP_KEY_ID_SIZE);
+		res = true;
+	}
+
+	return res;
+}
+
+static bool server_tree_hash(siap_device_tag* dtag, const server_key_tree* tree)
+{
+	size_t depth;
+	size_t tsize;
+	bool res;
+
+	tsize = tree->count * SIAP_AUTHENTICATION_TOKEN_SIZE;
+	/* only the Merkle mode stores a path */
+	dtag->kdepth = 0U;
+	qsc_memutils_clear(dtag->kpath, SIAP_KHASH_PATH_SIZE);
+
+	if (dtag->kmode == siap_khash_mode_merkle)
+	{
+		/* the path holds one hash per tree level */
+		depth = server_tree_depth(tree->count);
+		res = (depth <= SIAP_KTREE_DEPTH_MAX &&
+			siap_khash_merkle_compute(dtag->khash, dtag->kpath, tree->ktree, tree->count, qsc_intutils_be8to32(tree->kid + SIAP_DID_SIZE)) == true);
+		dtag->kdepth = (res == true) ? (uint8_t)depth : 0U;
+	}
+	else if (SERVER_TAG_COMMITTED(dtag) == true)
+	{
+		/* the key tree is encrypted, commit to the mac appended to the tree */
+		siap_khash_mac_commit(dtag->khash, tree->kid, tree->ktree + tsize);
+		res = true;
+	}
+	else
+	{
+		res = siap_khash_compute(dtag->khash, tree->ktree, tsize, dtag->kmode);
+	}
+
+	return res;
+}
+
+static bool server_tree_transform(const server_key_tree* tree, const siap_server_prepared_key* pkey, const uint8_t* phash, bool encryption, siap_server_scratch* scratch)
+{
+	bool res;
+
+	server_cipher_initialize(scratch, pkey, tree->kid, phash, tree->info, tree->infolen, encryption);
+
+	/* transform the token-tree in place, the mac is appended to the tree;
+	   the counter mode transform reads each block before writing it at the same offset,
+	   and the tree is left unchanged if the mac check fails */
+	res = qsc_rcs_transform(&scratch->rstate, tree->ktree, tree->ktree, tree->count * SIAP_AUTHENTICATION_TOKEN_SIZE);
+
+	/* cleanup */
+	qsc_rcs_dispose(&scratch->rstate);
+
+	return res;
+}
+
+static void server_tree_update(siap_device_tag* dtag, const server_key_tree* tree)
+{
+	uint32_t kidx;
+	uint32_t tidx;
+	bool res;
+
+	kidx = qsc_intutils_be8to32(tree->kid + SIAP_DID_SIZE);
+	tidx = qsc_intutils_be8to32(dtag->kid + SIAP_DID_SIZE);
+
+	/* a Merkle tag that is one token behind the key only needs its path moved */
+	res = (dtag->kmode == siap_khash_mode_merkle && qsc_memutils_are_equal(dtag->kid, tree->kid, SIAP_DID_SIZE) == true &&
+		tidx + 1U == kidx && server_tree_depth(tree->count) == dtag->kdepth &&
+		siap_khash_merkle_advance(dtag->khash, dtag->kpath, tree->ktree, tree->count, kidx) == true);
+
+	qsc_memutils_copy(dtag->kid, tree->kid, SIAP_KID_SIZE);
+
+	if (res == false)
+	{
+		/* otherwise re-hash the full key tree */
+		(void)server_tree_hash(dtag, tree);
+	}
+}
+
+static void server_tree_variable(server_key_tree* tree, uint8_t* info, const siap_variable_key* vkey)
+{
+	/* the tree size is bound to the cipher through the info string */
+	info[0U] = (uint8_t)siap_card_format_variable;
+	qsc_intutils_le32to8(info + SIAP_CARD_FORMAT_SIZE, vkey->kcount);
+
+	tree->ktree = vkey->ktree;
+	tree->kid = (uint8_t*)vkey->kid;
+	tree->info = info;
+	tree->infolen = SIAP_CARD_FORMAT_SIZE + SIAP_KTREE_COUNT_SIZE;
+	tree->count = vkey->kcount;
+	tree->expiration = vkey->expiration;
+}
+
+static bool server_tree_verify(const siap_device_tag* dtag, const server_key_tree* tree, uint8_t* tmph)
+{
+	size_t depth;
+	size_t tsize;
+	uint32_t kidx;
+	bool res;
+
+	res = false;
+	tsize = tree->count * SIAP_AUTHENTICATION_TOKEN_SIZE;
+
+	if (dtag->kmode == siap_khash_mode_merkle)
+	{
+		/* fold the current token up its authentication path */
+		kidx = qsc_intutils_be8to32(tree->kid + SIAP_DID_SIZE);
+		depth = server_tree_depth(tree->count);
+
+		if (kidx < tree->count && depth == dtag->kdepth)
+		{
+			res = siap_khash_merkle_verify(dtag->khash, dtag->kpath, tree->ktree + (kidx * SIAP_AUTHENTICATION_TOKEN_SIZE), kidx, depth);
+		}
+	}
+	else if (SERVER_TAG_COMMITTED(dtag) == true)
+	{
+		/* compare the commitment to the encrypted key tree mac and kid */
+		siap_khash_mac_commit(tmph, tree->kid, tree->ktree + tsize);
+		res = (qsc_intutils_verify(tmph, dtag->khash, SIAP_KTAG_STATE_HASH) == 0U);
+	}
+	else if (siap_khash_compute(tmph, tree->ktree, tsize, dtag->kmode) == true)
+	{
+		/* hash the key tree in the tag mode; an unknown mode fails */
+		res = (qsc_intutils_verify(tmph, dtag->khash, SIAP_KTAG_STATE_HASH) == 0U);
+	}
+
+	return res;
+}
+
+static siap_errors server_tree_authenticate(uint8_t* dtok, const server_key_tree* tree, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch)
+{
+	siap_errors err;
+	bool res;
+
+	/* compare the kids, check the expiration time, and verify the passphrase hash */
+	err = server_verify_device(tree->kid, tree->expiration, dtag, pkey, phash);
+
+	if (err == siap_error_none)
+	{
+		bool kcommit;
+		bool kfused;
+
+		kcommit = SERVER_TAG_COMMITTED(dtag);
+
+		/* a mac commitment tag is checked against the ciphertext before decryption, the cipher mac then covers the tree;
+		   the cipher checks the mac before it decrypts, so no plaintext is produced or hashed from a tree that fails it */
+		res = (kcommit == false || server_tree_verify(dtag, tree, scratch->tmph) == true) &&
+			server_tree_transform(tree, pkey, dtag->phash, false, scratch);
+
+		if (res == true)
+		{
+			/* verify the decrypted token key tree is unaltered */
+			if (kcommit == false)
+			{
+				res = server_tree_verify(dtag, tree, scratch->tmph);
+			}
+
+			if (res == true)
+			{
+				/* extract the authentication token from the device key */
+				res = server_tree_extract(dtok, tree);
+
+				if (res == true)
+				{
+					/* generate a token at the server and compare */
+					res = (qsc_intutils_be8to32(dtag->kid + SIAP_DID_SIZE) < tree->count);
+
+					if (res == true)
+					{
+						server_derive_token(scratch->stok, &scratch->cenc, pkey, dtag->kid);
+						res = qsc_memutils_are_equal(dtok, scratch->stok, SIAP_AUTHENTICATION_TOKEN_SIZE);
+
+						if (res == true)
+						{
+							/* important! make sure to re-save both of these structures to file */
+
+							/* update the device tag and encrypt the device key */
+							kfused = siap_khash_initialize(&scratch->kstate, dtag->kmode);
+
+							if (kfused == true)
+							{
+								/* hash the plaintext tree in the encryption pass */
+								qsc_memutils_copy(dtag->kid, tree->kid, SIAP_KID_SIZE);
+								server_fused_encrypt(tree, &scratch->kstate, pkey, phash, scratch);
+								siap_khash_finalize(&scratch->kstate, dtag->khash);
+							}
+							else if (kcommit == true)
+							{
+								/* commit the tag to the new mac */
+								qsc_memutils_copy(dtag->kid, tree->kid, SIAP_KID_SIZE);
+								server_fused_encrypt(tree, NULL, pkey, phash, scratch);
+								(void)server_tree_hash(dtag, tree);
+							}
+							else
+							{
+								/* the Merkle path is moved before encryption */
+								server_tree_update(dtag, tree);
+								server_fused_encrypt(tree, NULL, pkey, phash, scratch);
+							}
+
+							err = siap_error_none;
+						}
+						else
+						{
+							err = siap_error_authentication_failure;
+						}
+					}
+					else
+					{
+						err = siap_error_token_not_created;
+					}
+				}
+				else
+				{
+					err = siap_error_token_invalid;
+				}
+			}
+			else
+			{
+				err = siap_error_decryption_failure;
+			}
+		}
+		else
+		{
+			err = siap_error_token_tree_invalid;
+		}
+	}
+
+	return err;
+}
 
 siap_errors siap_server_authenticate_device(uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const siap_server_key* skey, const uint8_t* phash)
+{
+	SIAP_ASSERT(skey != NULL);
+
+	siap_server_prepared_key pkey = { 0 };
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		err = siap_server_authenticate_device_prepared(dtok, dkey, dtag, &pkey, phash);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+
+	return err;
+}
+
+siap_errors siap_server_authenticate_device_prepared(uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash)
+{
+	siap_server_scratch scratch = { 0 };
+
+	return siap_server_authenticate_device_scratch(dtok, dkey, dtag, pkey, phash, &scratch);
+}
+
+siap_errors siap_server_authenticate_device_scratch(uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch)
+{
+	SIAP_ASSERT(dtok != NULL);
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(dtag != NULL);
+	SIAP_ASSERT(pkey != NULL);
+	SIAP_ASSERT(phash != NULL);
+	SIAP_ASSERT(scratch != NULL);
+
+	server_key_tree tree;
+	siap_errors err;
+
+	if (dtok != NULL && dkey != NULL && dtag != NULL && pkey != NULL && phash != NULL && scratch != NULL)
+	{
+		server_tree_device(&tree, dkey);
+		err = server_tree_authenticate(dtok, &tree, dtag, pkey, phash, scratch);
+
+		/* every temporary is in the scratch workspace, so it is erased once */
+		qsc_memutils_secure_erase(scratch, sizeof(siap_server_scratch));
+	}
+	else
+	{
+		err = siap_error_invalid_input;
+	}
+
+	return err;
+}
+
+siap_errors siap_server_authenticate_segmented_key(uint8_t* dtok, siap_segmented_key* dkey, siap_device_tag* dtag, const siap_server_key* skey, const uint8_t* phash)
+{
+	siap_server_prepared_key pkey;
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (siap_server_prepare_key(&pkey, skey) == true)
+	{
+		err = siap_server_authenticate_segmented_key_prepared(dtok, dkey, dtag, &pkey, phash);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+
+	return err;
+}
+
+siap_errors siap_server_authenticate_segmented_key_prepared(uint8_t* dtok, siap_segmented_key* dkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash)
+{
+	siap_server_scratch scratch = { 0 };
+
+	return siap_server_authenticate_segmented_key_scratch(dtok, dkey, dtag, pkey, phash, &scratch);
+}
+
+siap_errors siap_server_authenticate_segmented_key_scratch(uint8_t* dtok, siap_segmented_key* dkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch)
 {
 	SIAP_ASSERT(dtok != NULL);
 	SIAP_ASSERT(dkey != NULL);
 	SIAP_ASSERT(dtag != NULL);
-	SIAP_ASSERT(skey != NULL);
+	SIAP_ASSERT(pkey != NULL);
 	SIAP_ASSERT(phash != NULL);
+	SIAP_ASSERT(scratch != NULL);
 
-	uint8_t stok[SIAP_AUTHENTICATION_TOKEN_SIZE] = { 0U };
+	siap_key_segment* seg;
+	size_t sidx;
+	size_t tpos;
+	uint32_t kidx;
 	siap_errors err;
 	bool res;
 
-	if (dtok != NULL && dkey != NULL && dtag != NULL && skey != NULL && phash != NULL)
+	if (dtok != NULL && dkey != NULL && dtag != NULL && pkey != NULL && phash != NULL && scratch != NULL)
 	{
-		/* start by comparing the device kid with the tag kid */
-		res = qsc_memutils_are_equal(dkey->kid, dtag->kid, SIAP_KID_SIZE);
+		/* compare the kids, check the expiration time, and verify the passphrase hash */
+		err = server_verify_device(dkey->kid, dkey->expiration, dtag, pkey, phash);
 
-		if (res == true)
+		if (err == siap_error_none)
 		{
-			uint64_t tnow;
-
-			tnow = qsc_timestamp_epochtime_seconds();
-
-			/* check for a valid expiration time */
-			res = (dkey->expiration <= skey->expiration &&
-				dkey->expiration > tnow &&
-				dkey->expiration <= (qsc_timestamp_epochtime_seconds() + SIAP_KEY_DURATION_SECONDS));
+			kidx = qsc_intutils_be8to32(dkey->kid + SIAP_DID_SIZE);
 
-			if (res == true)
+			if (kidx < SIAP_KTREE_COUNT && dtag->kmode == siap_khash_mode_segment)
 			{
-				/* verify the passphrase hash */
-				res = (qsc_intutils_verify(dtag->phash, phash, SIAP_HASH_SIZE) == 0U);
+				sidx = kidx / SIAP_KSEGMENT_TOKENS;
+				seg = &dkey->segments[sidx];
+
+				/* check the tag commitment to the active segment before decrypting it */
+				siap_khash_segment_commit(scratch->tmph, (uint32_t)sidx, seg->sequence, seg->stree + SIAP_KSEGMENT_SIZE);
+				res = (qsc_intutils_verify(scratch->tmph, dtag->khash, SIAP_KTAG_STATE_HASH) == 0U);
 
 				if (res == true)
 				{
-					/* decrypt the device key */
-					res = siap_server_decrypt_device_key(dkey, skey, dtag->phash);
+					/* decrypt the active segment only */
+					res = server_segment_decrypt(dkey, sidx, pkey, dtag->phash, scratch);
 
 					if (res == true)
 					{
-						/* verify the token key tree is unaltered */
-						res = siap_server_verify_device_tag(dtag, dkey);
+						/* copy the token, clear it from the segment, and increment the kid counter */
+						tpos = (kidx % SIAP_KSEGMENT_TOKENS) * SIAP_AUTHENTICATION_TOKEN_SIZE;
+						qsc_memutils_copy(dtok, seg->stree + tpos, SIAP_AUTHENTICATION_TOKEN_SIZE);
+						qsc_memutils_secure_erase(seg->stree + tpos, SIAP_AUTHENTICATION_TOKEN_SIZE);
+						qsc_intutils_be8increment(dkey->kid + SIAP_DID_SIZE, SIAP_KEY_ID_SIZE);
+
+						/* generate a token at the server and compare */
+						res = (qsc_intutils_be8to32(dtag->kid + SIAP_DID_SIZE) < SIAP_KTREE_COUNT);
 
 						if (res == true)
 						{
-							/* extract the authentication token from the device key */
-							res = siap_server_extract_authentication_token(dtok, dkey, skey);
+							server_derive_token(scratch->stok, &scratch->cenc, pkey, dtag->kid);
+							res = qsc_memutils_are_equal(dtok, scratch->stok, SIAP_AUTHENTICATION_TOKEN_SIZE);
 
 							if (res == true)
 							{
-								/* generate a token at the server and compare */
-								res = siap_server_generate_authentication_token(stok, dtag, skey);
-
-								if (res == true)
-								{
-									res = qsc_memutils_are_equal(dtok, stok, SIAP_AUTHENTICATION_TOKEN_SIZE);
-
-									/* cleanup */
-									qsc_memutils_secure_erase(stok, SIAP_AUTHENTICATION_TOKEN_SIZE);
-
-									if (res == true)
-									{
-										/* important! make sure to re-save both of these structures to file */
-
-										/* update the device tag */
-										siap_server_generate_device_tag(dtag, dkey, phash);
-										/* encrypt the device key */
-										siap_server_encrypt_device_key(dkey, skey, phash);
-										err = siap_error_none;
-									}
-									else
-									{
-										err = siap_error_authentication_failure;
-									}
-								}
-								else
-								{
-									err = siap_error_token_not_created;
-								}
+								/* important! make sure to re-save the header, the active segment, and the tag */
+
+								/* re-encrypt the segment under the new counter value, and commit the tag to the next segment */
+								server_segment_encrypt(dkey, sidx, kidx + 1U, pkey, phash, scratch);
+								qsc_memutils_copy(dtag->kid, dkey->kid, SIAP_KID_SIZE);
+								server_segment_commit(dtag, dkey);
+								err = siap_error_none;
 							}
 							else
 							{
-								err = siap_error_token_invalid;
+								err = siap_error_authentication_failure;
 							}
 						}
 						else
 						{
-							err = siap_error_decryption_failure;
+							err = siap_error_token_not_created;
 						}
 					}
 					else
 					{
-						err = siap_error_token_tree_invalid;
+						err = siap_error_decryption_failure;
 					}
 				}
 				else
 				{
-					err = siap_error_passphrase_unrecognized;
+					err = siap_error_token_tree_invalid;
 				}
 			}
 			else
 			{
-				err = siap_error_key_expired;
+				err = siap_error_token_invalid;
 			}
 		}
-		else
-		{
-			err = siap_error_identity_mismatch;
-		}
+
+		qsc_memutils_secure_erase(scratch, sizeof(siap_server_scratch));
+	}
+	else
+	{
+		err = siap_error_invalid_input;
+	}
+
+	return err;
+}
+
+siap_errors siap_server_authenticate_variable_key(uint8_t* dtok, siap_variable_key* vkey, siap_device_tag* dtag, const siap_server_key* skey, const uint8_t* phash)
+{
+	SIAP_ASSERT(skey != NULL);
+
+	siap_server_prepared_key pkey = { 0 };
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		err = siap_server_authenticate_variable_key_prepared(dtok, vkey, dtag, &pkey, phash);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+
+	return err;
+}
+
+siap_errors siap_server_authenticate_variable_key_prepared(uint8_t* dtok, siap_variable_key* vkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash)
+{
+	siap_server_scratch scratch = { 0 };
+
+	return siap_server_authenticate_variable_key_scratch(dtok, vkey, dtag, pkey, phash, &scratch);
+}
+
+siap_errors siap_server_authenticate_variable_key_scratch(uint8_t* dtok, siap_variable_key* vkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch)
+{
+	SIAP_ASSERT(dtok != NULL);
+	SIAP_ASSERT(vkey != NULL);
+	SIAP_ASSERT(dtag != NULL);
+	SIAP_ASSERT(pkey != NULL);
+	SIAP_ASSERT(phash != NULL);
+	SIAP_ASSERT(scratch != NULL);
+
+	uint8_t info[SIAP_CARD_FORMAT_SIZE + SIAP_KTREE_COUNT_SIZE] = { 0U };
+	server_key_tree tree;
+	siap_errors err;
+
+	if (dtok != NULL && vkey != NULL && vkey->ktree != NULL && dtag != NULL && pkey != NULL && phash != NULL && scratch != NULL)
+	{
+		server_tree_variable(&tree, info, vkey);
+		err = server_tree_authenticate(dtok, &tree, dtag, pkey, phash, scratch);
+		qsc_memutils_secure_erase(scratch, sizeof(siap_server_scratch));
 	}
 	else
 	{
@@ -129,28 +857,45 @@ siap_errors siap_server_authenticate_device(uint8_t* dtok, siap_device_key* dkey
 }
 
 bool siap_server_generate_authentication_token(uint8_t* token, const siap_device_tag* dtag, const siap_server_key* skey)
+{
+	SIAP_ASSERT(skey != NULL);
+
+	siap_server_prepared_key pkey = { 0 };
+	bool res;
+
+	res = false;
+
+	if (skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		res = siap_server_generate_authentication_token_prepared(token, dtag, &pkey);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+
+	return res;
+}
+
+bool siap_server_generate_authentication_token_prepared(uint8_t* token, const siap_device_tag* dtag, const siap_server_prepared_key* pkey)
 {
 	SIAP_ASSERT(token != NULL);
 	SIAP_ASSERT(dtag != NULL);
-	SIAP_ASSERT(skey != NULL);
+	SIAP_ASSERT(pkey != NULL);
 
+	siap_cshake_encoded tenc;
 	uint32_t kidx;
 	bool res;
 
 	res = false;
 
-	if (token != NULL && dtag != NULL && skey != NULL)
+	if (token != NULL && dtag != NULL && pkey != NULL)
 	{
 		/* get the current key index and key pointer */
 		kidx = qsc_intutils_be8to32(dtag->kid + SIAP_DID_SIZE);
 
 		if (kidx < SIAP_KTREE_COUNT)
 		{
-#if defined(SIAP_EXTENDED_ENCRYPTION)
-			qsc_cshake512_compute(token, SIAP_AUTHENTICATION_TOKEN_SIZE, skey->kbase, SIAP_SERVER_KEY_SIZE, (uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE, dtag->kid, SIAP_KID_SIZE);
-#else
-			qsc_cshake256_compute(token, SIAP_AUTHENTICATION_TOKEN_SIZE, skey->kbase, SIAP_SERVER_KEY_SIZE, (uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE, dtag->kid, SIAP_KID_SIZE);
-#endif
+			server_derive_token(token, &tenc, pkey, dtag->kid);
+			qsc_memutils_secure_erase(&tenc, sizeof(tenc));
 			res = true;
 		}
 	}
@@ -160,46 +905,83 @@ bool siap_server_generate_authentication_token(uint8_t* token, const siap_device
 
 bool siap_server_decrypt_device_key(siap_device_key* dkey, const siap_server_key* skey, const uint8_t* phash)
 {
-	SIAP_ASSERT(dkey != NULL);
 	SIAP_ASSERT(skey != NULL);
+
+	siap_server_prepared_key pkey = { 0 };
+	bool res;
+
+	res = false;
+
+	if (skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		res = siap_server_decrypt_device_key_prepared(dkey, &pkey, phash);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+
+	return res;
+}
+
+bool siap_server_decrypt_device_key_prepared(siap_device_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* phash)
+{
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(pkey != NULL);
 	SIAP_ASSERT(phash != NULL);
 
-	uint8_t dect[SIAP_KTREE_SIZE] = { 0U };
-	uint8_t pkey[SIAP_SERVER_KEY_SIZE + SIAP_NONCE_SIZE] = { 0U };
+	siap_server_scratch scratch = { 0 };
+	server_key_tree tree;
 	bool res;
 
 	res = false;
 
-	if (dkey != NULL && skey != NULL && phash != NULL)
+	if (dkey != NULL && pkey != NULL && phash != NULL)
 	{
-		/* using kid as the name param with the incrementing kidx ensures key/nonce uniqueness every encryption cycle */
-		/* key hash is: passphrase-hash + device-id + counter + server-salt: k = H(ph, did/kidx++, s) */
-#if defined(SIAP_EXTENDED_ENCRYPTION)
-		qsc_cshake512_compute(pkey, sizeof(pkey), phash, SIAP_HASH_SIZE, dkey->kid, SIAP_KID_SIZE, skey->dsalt, SIAP_SALT_SIZE);
-#else
-		qsc_cshake256_compute(pkey, sizeof(pkey), phash, SIAP_HASH_SIZE, dkey->kid, SIAP_KID_SIZE, skey->dsalt, SIAP_SALT_SIZE);
-#endif
+		/* authenticate and conditionally decrypt the token-tree in place */
+		server_tree_device(&tree, dkey);
+		res = server_tree_transform(&tree, pkey, phash, false, &scratch);
+		qsc_memutils_secure_erase(&scratch, sizeof(scratch));
+	}
 
-		qsc_rcs_keyparams kp = { .info = NULL, .infolen = 0U, .key = pkey, .keylen = SIAP_SERVER_KEY_SIZE, .nonce = pkey + SIAP_SERVER_KEY_SIZE };
-		qsc_rcs_state rstate = { 0U };
+	return res;
+}
 
-		/* initialize the cipher */
-		qsc_rcs_initialize(&rstate, &kp, false);
+bool siap_server_decrypt_variable_key(siap_variable_key* vkey, const siap_server_key* skey, const uint8_t* phash)
+{
+	SIAP_ASSERT(skey != NULL);
 
-		/* authenticate and conditionally decrypt token-tree */
-		res = qsc_rcs_transform(&rstate, dect, dkey->ktree, SIAP_KTREE_SIZE);
+	siap_server_prepared_key pkey = { 0 };
+	bool res;
 
-		if (res == true)
-		{
-			/* copy to tree state */
-			qsc_memutils_copy(dkey->ktree, dect, SIAP_KTREE_SIZE);
-			
-		}
+	res = false;
+
+	if (skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		res = siap_server_decrypt_variable_key_prepared(vkey, &pkey, phash);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+
+	return res;
+}
+
+bool siap_server_decrypt_variable_key_prepared(siap_variable_key* vkey, const siap_server_prepared_key* pkey, const uint8_t* phash)
+{
+	SIAP_ASSERT(vkey != NULL);
+	SIAP_ASSERT(pkey != NULL);
+	SIAP_ASSERT(phash != NULL);
+
+	uint8_t info[SIAP_CARD_FORMAT_SIZE + SIAP_KTREE_COUNT_SIZE] = { 0U };
+	siap_server_scratch scratch = { 0 };
+	server_key_tree tree;
+	bool res;
+
+	res = false;
 
-		/* cleanup */
-		qsc_memutils_secure_erase(dect, sizeof(dect));
-		qsc_memutils_secure_erase(pkey, sizeof(pkey));
-		qsc_rcs_dispose(&rstate);
+	if (vkey != NULL && vkey->ktree != NULL && pkey != NULL && phash != NULL)
+	{
+		server_tree_variable(&tree, info, vkey);
+		res = server_tree_transform(&tree, pkey, phash, false, &scratch);
+		qsc_memutils_secure_erase(&scratch, sizeof(scratch));
 	}
 
 	return res;
@@ -207,36 +989,101 @@ bool siap_server_decrypt_device_key(siap_device_key* dkey, const siap_server_key
 
 void siap_server_encrypt_device_key(siap_device_key* dkey, const siap_server_key* skey, const uint8_t* phash)
 {
-	SIAP_ASSERT(dkey != NULL);
 	SIAP_ASSERT(skey != NULL);
+
+	siap_server_prepared_key pkey = { 0 };
+
+	if (skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		siap_server_encrypt_device_key_prepared(dkey, &pkey, phash);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+}
+
+void siap_server_encrypt_device_key_prepared(siap_device_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* phash)
+{
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(pkey != NULL);
 	SIAP_ASSERT(phash != NULL);
 
-	uint8_t enkt[SIAP_KTREE_SIZE + SIAP_MAC_SIZE] = { 0U };
-	uint8_t pkey[SIAP_SERVER_KEY_SIZE + SIAP_NONCE_SIZE] = { 0U };
+	siap_server_scratch scratch = { 0 };
+	server_key_tree tree;
 
-	if (dkey != NULL && skey != NULL && phash != NULL)
+	if (dkey != NULL && pkey != NULL && phash != NULL)
 	{
-		/* key hash is: passphrase-hash + device-id + counter + server-salt: k = H(ph, did/kidx++, s) */
-#if defined(SIAP_EXTENDED_ENCRYPTION)
-		qsc_cshake512_compute(pkey, sizeof(pkey), phash, SIAP_HASH_SIZE, dkey->kid, SIAP_KID_SIZE, skey->dsalt, SIAP_SALT_SIZE);
-#else
-		qsc_cshake256_compute(pkey, sizeof(pkey), phash, SIAP_HASH_SIZE, dkey->kid, SIAP_KID_SIZE, skey->dsalt, SIAP_SALT_SIZE);
-#endif
+		/* encrypt the token tree in place, the mac is appended to the ktree array */
+		server_tree_device(&tree, dkey);
+		(void)server_tree_transform(&tree, pkey, phash, true, &scratch);
+		qsc_memutils_secure_erase(&scratch, sizeof(scratch));
+	}
+}
 
-		qsc_rcs_keyparams kp = { .info = NULL, .infolen = 0U, .key = pkey, .keylen = SIAP_SERVER_KEY_SIZE, .nonce = pkey + SIAP_SERVER_KEY_SIZE };
-		qsc_rcs_state rstate = { 0U };
+void siap_server_encrypt_segmented_key(siap_segmented_key* dkey, const siap_server_key* skey, const uint8_t* phash)
+{
+	siap_server_prepared_key pkey;
+
+	if (siap_server_prepare_key(&pkey, skey) == true)
+	{
+		siap_server_encrypt_segmented_key_prepared(dkey, &pkey, phash);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+}
+
+void siap_server_encrypt_segmented_key_prepared(siap_segmented_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* phash)
+{
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(pkey != NULL);
+	SIAP_ASSERT(phash != NULL);
+
+	siap_server_scratch scratch = { 0 };
+	uint32_t kctr;
+
+	if (dkey != NULL && pkey != NULL && phash != NULL)
+	{
+		/* every segment is encrypted under the current counter value, and its own index */
+		kctr = qsc_intutils_be8to32(dkey->kid + SIAP_DID_SIZE);
+
+		for (size_t i = 0U; i < SIAP_KSEGMENT_COUNT; ++i)
+		{
+			server_segment_encrypt(dkey, i, kctr, pkey, phash, &scratch);
+		}
 
-		/* initialize the cipher */
-		qsc_rcs_initialize(&rstate, &kp, true);
-		/* encrypt the token tree */
-		(void)qsc_rcs_transform(&rstate, enkt, dkey->ktree, SIAP_KTREE_SIZE);
-		/* copy to device key token-tree */
-		qsc_memutils_copy(dkey->ktree, enkt, SIAP_KTREE_SIZE + SIAP_MAC_SIZE);
+		qsc_memutils_secure_erase(&scratch, sizeof(scratch));
+	}
+}
+
+void siap_server_encrypt_variable_key(siap_variable_key* vkey, const siap_server_key* skey, const uint8_t* phash)
+{
+	SIAP_ASSERT(skey != NULL);
+
+	siap_server_prepared_key pkey = { 0 };
+
+	if (skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		siap_server_encrypt_variable_key_prepared(vkey, &pkey, phash);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+}
+
+void siap_server_encrypt_variable_key_prepared(siap_variable_key* vkey, const siap_server_prepared_key* pkey, const uint8_t* phash)
+{
+	SIAP_ASSERT(vkey != NULL);
+	SIAP_ASSERT(pkey != NULL);
+	SIAP_ASSERT(phash != NULL);
 
-		/* cleanup */
-		qsc_memutils_secure_erase(enkt, sizeof(enkt));
-		qsc_memutils_secure_erase(pkey, sizeof(pkey));
-		qsc_rcs_dispose(&rstate);
+	uint8_t info[SIAP_CARD_FORMAT_SIZE + SIAP_KTREE_COUNT_SIZE] = { 0U };
+	siap_server_scratch scratch = { 0 };
+	server_key_tree tree;
+
+	if (vkey != NULL && vkey->ktree != NULL && pkey != NULL && phash != NULL)
+	{
+		/* the token count is bound to the cipher, so a header with an altered count fails authentication */
+		server_tree_variable(&tree, info, vkey);
+		(void)server_tree_transform(&tree, pkey, phash, true, &scratch);
+		qsc_memutils_secure_erase(&scratch, sizeof(scratch));
 	}
 }
 
@@ -246,80 +1093,208 @@ bool siap_server_extract_authentication_token(uint8_t* token, siap_device_key* d
 	SIAP_ASSERT(dkey != NULL);
 	SIAP_ASSERT(skey != NULL);
 
-	uint32_t kidx;
+	server_key_tree tree;
 	bool res;
 
 	res = false;
 
 	if (token != NULL && dkey != NULL && skey != NULL)
 	{
-		/* get the current key index and key pointer */
-		kidx = qsc_intutils_be8to32(dkey->kid + SIAP_DID_SIZE);
+		server_tree_device(&tree, dkey);
+		res = server_tree_extract(token, &tree);
+	}
 
-		if (kidx < SIAP_KTREE_COUNT)
+	return res;
+}
+
+void siap_server_generate_device_key(siap_device_key* dkey, const siap_server_key* skey, const uint8_t* did)
+{
+	SIAP_ASSERT(skey != NULL);
+
+	siap_server_prepared_key pkey = { 0 };
+
+	if (skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		siap_server_generate_device_key_prepared(dkey, &pkey, did);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+}
+
+void siap_server_generate_device_key_prepared(siap_device_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* did)
+{
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(pkey != NULL);
+	SIAP_ASSERT(did != NULL);
+
+	uint32_t kctr;
+
+	if (dkey != NULL && pkey != NULL && did != NULL)
+	{
+		/* copy the did */
+		qsc_memutils_copy(dkey->kid, did, SIAP_DID_SIZE);
+
+		/* set the expiration time */
+		dkey->expiration = pkey->skey.expiration;
+
+		/* generate the token set, starting at the current kid counter */
+		kctr = qsc_intutils_be8to32(dkey->kid + SIAP_DID_SIZE);
+		server_generate_tokens(dkey->ktree, pkey, dkey->kid, kctr, SIAP_KTREE_COUNT);
+
+		/* reset the counter */
+		qsc_memutils_clear(dkey->kid + SIAP_DID_SIZE, SIAP_KEY_ID_SIZE);
+	}
+}
+
+void siap_server_generate_device_tag(siap_device_tag* dtag, const siap_device_key* dkey, const uint8_t* phash)
+{
+	SIAP_ASSERT(dtag != NULL);
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(phash != NULL);
+
+	server_key_tree tree;
+
+	if (dtag != NULL && dkey != NULL && phash != NULL)
+	{
+		/* copy the kid */
+		qsc_memutils_copy(dtag->kid, dkey->kid, SIAP_KID_SIZE);
+		/* copy the passphrase hash*/
+		qsc_memutils_copy(dtag->phash, phash, SIAP_HASH_SIZE);
+
+		/* hash the key tree in the tag mode and add it to khash */
+		server_tree_device(&tree, dkey);
+		(void)server_tree_hash(dtag, &tree);
+	}
+}
+
+void siap_server_generate_segmented_key(siap_segmented_key* dkey, const siap_server_key* skey, const uint8_t* did)
+{
+	siap_server_prepared_key pkey;
+
+	if (siap_server_prepare_key(&pkey, skey) == true)
+	{
+		siap_server_generate_segmented_key_prepared(dkey, &pkey, did);
+	}
+
+	siap_server_prepared_key_dispose(&pkey);
+}
+
+void siap_server_generate_segmented_key_prepared(siap_segmented_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* did)
+{
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(pkey != NULL);
+	SIAP_ASSERT(did != NULL);
+
+	uint32_t kctr;
+
+	if (dkey != NULL && pkey != NULL && did != NULL)
+	{
+		/* copy the did */
+		qsc_memutils_copy(dkey->kid, did, SIAP_DID_SIZE);
+
+		/* set the expiration time */
+		dkey->expiration = pkey->skey.expiration;
+
+		/* generate the token set one segment at a time, starting at the current kid counter */
+		kctr = qsc_intutils_be8to32(dkey->kid + SIAP_DID_SIZE);
+
+		for (size_t i = 0U; i < SIAP_KSEGMENT_COUNT; ++i)
 		{
-			/* copy the token and clear it from the tree */
-			qsc_memutils_copy(token, dkey->ktree + (kidx * SIAP_AUTHENTICATION_TOKEN_SIZE), SIAP_AUTHENTICATION_TOKEN_SIZE);
-			qsc_memutils_secure_erase(dkey->ktree + (kidx * SIAP_AUTHENTICATION_TOKEN_SIZE), SIAP_AUTHENTICATION_TOKEN_SIZE);
-			/* increment the kid counter */
-			qsc_intutils_be8increment(dkey->kid + SIAP_DID_SIZE, SIAP_KEY_ID_SIZE);
-			res = true;
+			server_generate_tokens(dkey->segments[i].stree, pkey, dkey->kid, kctr, SIAP_KSEGMENT_TOKENS);
+			dkey->segments[i].sequence = 0U;
+			kctr += SIAP_KSEGMENT_TOKENS;
 		}
+
+		/* reset the counter */
+		qsc_memutils_clear(dkey->kid + SIAP_DID_SIZE, SIAP_KEY_ID_SIZE);
+	}
+}
+
+void siap_server_generate_segmented_tag(siap_device_tag* dtag, const siap_segmented_key* dkey, const uint8_t* phash)
+{
+	SIAP_ASSERT(dtag != NULL);
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(phash != NULL);
+
+	if (dtag != NULL && dkey != NULL && phash != NULL)
+	{
+		dtag->kmode = siap_khash_mode_segment;
+		/* copy the kid */
+		qsc_memutils_copy(dtag->kid, dkey->kid, SIAP_KID_SIZE);
+		/* copy the passphrase hash*/
+		qsc_memutils_copy(dtag->phash, phash, SIAP_HASH_SIZE);
+		dtag->kdepth = 0U;
+		qsc_memutils_clear(dtag->kpath, SIAP_KHASH_PATH_SIZE);
+
+		/* commit to the mac of the active segment */
+		server_segment_commit(dtag, dkey);
+	}
+}
+
+void siap_server_generate_variable_key(siap_variable_key* vkey, const siap_server_key* skey, const uint8_t* did)
+{
+	SIAP_ASSERT(skey != NULL);
+
+	siap_server_prepared_key pkey = { 0 };
+
+	if (skey != NULL && siap_server_prepare_key(&pkey, skey) == true)
+	{
+		siap_server_generate_variable_key_prepared(vkey, &pkey, did);
 	}
 
-	return res;
+	siap_server_prepared_key_dispose(&pkey);
 }
 
-void siap_server_generate_device_key(siap_device_key* dkey, const siap_server_key* skey, const uint8_t* did)
+void siap_server_generate_variable_key_prepared(siap_variable_key* vkey, const siap_server_prepared_key* pkey, const uint8_t* did)
 {
-	SIAP_ASSERT(dkey != NULL);
-	SIAP_ASSERT(skey != NULL);
+	SIAP_ASSERT(vkey != NULL);
+	SIAP_ASSERT(pkey != NULL);
 	SIAP_ASSERT(did != NULL);
 
-	if (dkey != NULL && skey != NULL && did != NULL)
+	uint32_t kctr;
+
+	if (vkey != NULL && vkey->ktree != NULL && pkey != NULL && did != NULL)
 	{
 		/* copy the did */
-		qsc_memutils_copy(dkey->kid, did, SIAP_DID_SIZE);
+		qsc_memutils_copy(vkey->kid, did, SIAP_DID_SIZE);
 
 		/* set the expiration time */
-		dkey->expiration = skey->expiration;
+		vkey->expiration = pkey->skey.expiration;
 
-		/* generate the token set; the incrementing kid/kidx in custom param creates a keccak counter-mode generator */
-		for (size_t i = 0U; i < SIAP_KTREE_COUNT; ++i)
-		{
-#if defined(SIAP_EXTENDED_ENCRYPTION)
-			qsc_cshake512_compute(dkey->ktree + (i * SIAP_AUTHENTICATION_TOKEN_SIZE), SIAP_AUTHENTICATION_TOKEN_SIZE, skey->kbase, SIAP_SERVER_KEY_SIZE, (uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE, dkey->kid, SIAP_KID_SIZE);
-#else
-			qsc_cshake256_compute(dkey->ktree + (i * SIAP_AUTHENTICATION_TOKEN_SIZE), SIAP_AUTHENTICATION_TOKEN_SIZE, skey->kbase, SIAP_SERVER_KEY_SIZE, (uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE, dkey->kid, SIAP_KID_SIZE);
-#endif
-			qsc_intutils_be8increment(dkey->kid + SIAP_DID_SIZE, SIAP_KEY_ID_SIZE);
-		}
+		/* generate the token set, starting at the current kid counter */
+		kctr = qsc_intutils_be8to32(vkey->kid + SIAP_DID_SIZE);
+		server_generate_tokens(vkey->ktree, pkey, vkey->kid, kctr, vkey->kcount);
 
 		/* reset the counter */
-		qsc_memutils_clear(dkey->kid + SIAP_DID_SIZE, SIAP_KEY_ID_SIZE);
+		qsc_memutils_clear(vkey->kid + SIAP_DID_SIZE, SIAP_KEY_ID_SIZE);
 	}
 }
 
-void siap_server_generate_device_tag(siap_device_tag* dtag, const siap_device_key* dkey, const uint8_t* phash)
+bool siap_server_generate_variable_tag(siap_device_tag* dtag, const siap_variable_key* vkey, const uint8_t* phash)
 {
 	SIAP_ASSERT(dtag != NULL);
-	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(vkey != NULL);
 	SIAP_ASSERT(phash != NULL);
 
-	if (dtag != NULL && dkey != NULL && phash != NULL)
+	uint8_t info[SIAP_CARD_FORMAT_SIZE + SIAP_KTREE_COUNT_SIZE] = { 0U };
+	server_key_tree tree;
+	bool res;
+
+	res = false;
+
+	if (dtag != NULL && vkey != NULL && vkey->ktree != NULL && phash != NULL)
 	{
 		/* copy the kid */
-		qsc_memutils_copy(dtag->kid, dkey->kid, SIAP_KID_SIZE);
+		qsc_memutils_copy(dtag->kid, vkey->kid, SIAP_KID_SIZE);
 		/* copy the passphrase hash*/
 		qsc_memutils_copy(dtag->phash, phash, SIAP_HASH_SIZE);
 
-		/* hash the entire key tree and add it to khash */
-#if defined(SIAP_EXTENDED_ENCRYPTION)
-		qsc_shake512_compute(dtag->khash, SIAP_KTAG_STATE_HASH, dkey->ktree, SIAP_KTREE_SIZE);
-#else
-		qsc_shake256_compute(dtag->khash, SIAP_KTAG_STATE_HASH, dkey->ktree, SIAP_KTREE_SIZE);
-#endif
+		/* hash the key tree in the tag mode */
+		server_tree_variable(&tree, info, vkey);
+		res = server_tree_hash(dtag, &tree);
 	}
+
+	return res;
 }
 
 bool siap_server_generate_server_key(siap_server_key* skey, const uint8_t* sid)
@@ -356,6 +1331,81 @@ bool siap_server_generate_server_key(siap_server_key* skey, const uint8_t* sid)
 	return res;
 }
 
+bool siap_server_issue_ticket(siap_session_ticket* ticket, const uint8_t* dtok, const siap_device_tag* dtag, const siap_server_prepared_key* pkey, uint32_t lifetime)
+{
+	SIAP_ASSERT(ticket != NULL);
+	SIAP_ASSERT(dtok != NULL);
+	SIAP_ASSERT(dtag != NULL);
+	SIAP_ASSERT(pkey != NULL);
+
+	uint64_t tnow;
+	uint32_t kidx;
+	bool res;
+
+	res = false;
+
+	if (ticket != NULL && dtok != NULL && dtag != NULL && pkey != NULL && lifetime != 0U)
+	{
+		/* the tag has moved to the next token, the ticket is bound to the one just spent */
+		kidx = qsc_intutils_be8to32(dtag->kid + SIAP_DID_SIZE);
+
+		if (kidx != 0U)
+		{
+			tnow = qsc_timestamp_epochtime_seconds();
+			qsc_memutils_copy(ticket->kid, dtag->kid, SIAP_DID_SIZE);
+			qsc_intutils_be32to8(ticket->kid + SIAP_DID_SIZE, kidx - 1U);
+			ticket->issued = tnow;
+			ticket->expiration = tnow + qsc_intutils_min(lifetime, SIAP_TICKET_DURATION_MAX);
+			ticket->expiration = qsc_intutils_min(ticket->expiration, pkey->skey.expiration);
+			server_ticket_mac(ticket->mac, ticket, dtok, pkey);
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+bool siap_server_prepare_key(siap_server_prepared_key* pkey, const siap_server_key* skey)
+{
+	SIAP_ASSERT(pkey != NULL);
+	SIAP_ASSERT(skey != NULL);
+
+	const uint8_t tkid[SIAP_KID_SIZE] = { 0U };
+	const uint8_t tphs[SIAP_HASH_SIZE] = { 0U };
+	bool res;
+
+	res = false;
+
+	if (pkey != NULL && skey != NULL)
+	{
+		qsc_memutils_copy(&pkey->skey, skey, sizeof(siap_server_key));
+
+		/* the token input is cSHAKE(kbase, config, kid); the kid is written at custpos */
+		res = siap_keccakx_cshake_encode(&pkey->ktoken, SERVER_KECCAK_RATE, skey->kbase, SIAP_SERVER_KEY_SIZE, (const uint8_t*)SIAP_CONFIG_STRING, SIAP_CONFIG_SIZE, tkid, SIAP_KID_SIZE);
+
+		if (res == true)
+		{
+			/* the cipher input is cSHAKE(phash, kid, dsalt); the kid is written at namepos and the passphrase hash at keypos */
+			res = siap_keccakx_cshake_encode(&pkey->kcipher, SERVER_KECCAK_RATE, tphs, SIAP_HASH_SIZE, tkid, SIAP_KID_SIZE, skey->dsalt, SIAP_SALT_SIZE);
+		}
+
+		if (res == false)
+		{
+			siap_server_prepared_key_dispose(pkey);
+		}
+	}
+
+	return res;
+}
+
+void siap_server_prepared_key_dispose(siap_server_prepared_key* pkey)
+{
+	if (pkey != NULL)
+	{
+		qsc_memutils_secure_erase(pkey, sizeof(siap_server_prepared_key));
+	}
+}
+
 void siap_server_passphrase_generate(char* passphrase, size_t length)
 {
 	SIAP_ASSERT(passphrase != NULL);
@@ -390,19 +1440,201 @@ void siap_server_passphrase_generate(char* passphrase, size_t length)
 	}
 }
 
+bool siap_server_passphrase_hash_batch(uint8_t* phashes, const char* const* passphrases, const size_t* passlens, size_t count, size_t cpucost, size_t memcost, size_t threads)
+{
+	SIAP_ASSERT(phashes != NULL);
+	SIAP_ASSERT(passphrases != NULL);
+	SIAP_ASSERT(passlens != NULL);
+
+	server_passphrase_task tasks[SERVER_BATCH_THREADS_MAX] = { 0 };
+	qsc_thread handles[SERVER_BATCH_THREADS_MAX] = { 0 };
+	bool started[SERVER_BATCH_THREADS_MAX] = { false };
+	size_t tcount;
+	bool res;
+
+	res = false;
+
+	if (phashes != NULL && passphrases != NULL && passlens != NULL && count != 0U)
+	{
+		tcount = (threads != 0U) ? threads : qsc_async_processor_count();
+		tcount = (tcount < SERVER_BATCH_THREADS_MAX) ? tcount : SERVER_BATCH_THREADS_MAX;
+		tcount = (tcount < count) ? tcount : count;
+		tcount = (tcount != 0U) ? tcount : 1U;
+
+		for (size_t i = 0U; i < tcount; ++i)
+		{
+			tasks[i].count = count;
+			tasks[i].cpucost = cpucost;
+			tasks[i].first = i;
+			tasks[i].memcost = memcost;
+			tasks[i].passlens = passlens;
+			tasks[i].passphrases = passphrases;
+			tasks[i].phashes = phashes;
+			tasks[i].stride = tcount;
+		}
+
+		/* the calling thread processes the first set, and the set of any thread that did not start */
+		for (size_t i = 1U; i < tcount; ++i)
+		{
+			started[i] = siap_affinity_thread_create(&handles[i], &server_passphrase_worker, &tasks[i]);
+		}
+
+		for (size_t i = 0U; i < tcount; ++i)
+		{
+			if (started[i] == false)
+			{
+				server_passphrase_worker(&tasks[i]);
+			}
+		}
+
+		res = true;
+
+		for (size_t i = 0U; i < tcount; ++i)
+		{
+			if (started[i] == true)
+			{
+				qsc_async_thread_wait(handles[i]);
+			}
+
+			res = (res == true && tasks[i].res == true);
+		}
+	}
+
+	return res;
+}
+
+bool siap_server_passphrase_hash_calibrate(uint8_t* cpucost, uint8_t* memcost, uint32_t target, size_t samples)
+{
+	SIAP_ASSERT(cpucost != NULL);
+	SIAP_ASSERT(memcost != NULL);
+
+	uint64_t tmax;
+	size_t cmax;
+	size_t cmin;
+	size_t mmax;
+	size_t mmin;
+	size_t tmp;
+	bool res;
+
+	res = false;
+
+	if (cpucost != NULL && memcost != NULL && samples != 0U && samples <= SERVER_CALIBRATE_SAMPLES_MAX)
+	{
+		tmax = (uint64_t)target * 1000ULL;
+		mmin = 1U;
+		cmin = 1U;
+
+		if (server_scb_latency(cmin, mmin, samples) <= tmax)
+		{
+			/* raise the memory cost first, doubling until the target is missed, then bisect */
+			mmax = mmin;
+
+			while (mmax < SIAP_SCB_MEMORY_COST_MAX && server_scb_latency(cmin, mmax * 2U, samples) <= tmax)
+			{
+				mmax *= 2U;
+			}
+
+			mmin = mmax;
+			mmax = (mmax * 2U < SIAP_SCB_MEMORY_COST_MAX) ? (mmax * 2U) : SIAP_SCB_MEMORY_COST_MAX;
+
+			while (mmax > mmin + 1U)
+			{
+				tmp = (mmin + mmax) / 2U;
+
+				if (server_scb_latency(cmin, tmp, samples) <= tmax)
+				{
+					mmin = tmp;
+				}
+				else
+				{
+					mmax = tmp;
+				}
+			}
+
+			if (mmax != mmin && server_scb_latency(cmin, mmax, samples) <= tmax)
+			{
+				mmin = mmax;
+			}
+
+			/* then raise the cpu cost at that memory cost */
+			cmax = cmin;
+
+			while (cmax < SIAP_SCB_CPU_COST_MAX && server_scb_latency(cmax * 2U, mmin, samples) <= tmax)
+			{
+				cmax *= 2U;
+			}
+
+			cmin = cmax;
+			cmax = (cmax * 2U < SIAP_SCB_CPU_COST_MAX) ? (cmax * 2U) : SIAP_SCB_CPU_COST_MAX;
+
+			while (cmax > cmin + 1U)
+			{
+				tmp = (cmin + cmax) / 2U;
+
+				if (server_scb_latency(tmp, mmin, samples) <= tmax)
+				{
+					cmin = tmp;
+				}
+				else
+				{
+					cmax = tmp;
+				}
+			}
+
+			if (cmax != cmin && server_scb_latency(cmax, mmin, samples) <= tmax)
+			{
+				cmin = cmax;
+			}
+
+			res = true;
+		}
+
+		*cpucost = (uint8_t)cmin;
+		*memcost = (uint8_t)mmin;
+	}
+
+	return res;
+}
+
 void siap_server_passphrase_hash_generate(uint8_t* phash, const char* passphrase, size_t passlen)
+{
+	(void)siap_server_passphrase_hash_generate_costs(phash, passphrase, passlen, SIAP_SCB_CPU_COST, SIAP_SCB_MEMORY_COST);
+}
+
+bool siap_server_passphrase_hash_generate_costs(uint8_t* phash, const char* passphrase, size_t passlen, size_t cpucost, size_t memcost)
 {
 	SIAP_ASSERT(phash != NULL);
 	SIAP_ASSERT(passphrase != NULL);
 
 	qsc_scb_state sscb = { 0U };
+	bool res;
+
+	res = false;
 
 	if (phash != NULL && passphrase != NULL)
 	{
-		qsc_scb_initialize(&sscb, (uint8_t*)passphrase, passlen, NULL, 0U, SIAP_SCB_CPU_COST, SIAP_SCB_MEMORY_COST);
-		qsc_scb_generate(&sscb, phash, SIAP_HASH_SIZE);
-		qsc_scb_dispose(&sscb);
+		res = server_passphrase_hash(phash, passphrase, passlen, cpucost, memcost, &sscb);
+	}
+
+	return res;
+}
+
+bool siap_server_passphrase_hash_generate_scratch(uint8_t* phash, const char* passphrase, size_t passlen, size_t cpucost, size_t memcost, siap_server_scratch* scratch)
+{
+	SIAP_ASSERT(phash != NULL);
+	SIAP_ASSERT(passphrase != NULL);
+	SIAP_ASSERT(scratch != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (phash != NULL && passphrase != NULL && scratch != NULL)
+	{
+		res = server_passphrase_hash(phash, passphrase, passlen, cpucost, memcost, &scratch->sscb);
 	}
+
+	return res;
 }
 
 bool siap_server_passphrase_hash_verify(const uint8_t* phash, const char* passphrase, size_t passlen)
@@ -424,27 +1656,150 @@ bool siap_server_passphrase_hash_verify(const uint8_t* phash, const char* passph
 	return res;
 }
 
+bool siap_server_passphrase_hash_verify_scratch(const uint8_t* phash, const char* passphrase, size_t passlen, size_t cpucost, size_t memcost, siap_server_scratch* scratch)
+{
+	SIAP_ASSERT(phash != NULL);
+	SIAP_ASSERT(passphrase != NULL);
+	SIAP_ASSERT(scratch != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (phash != NULL && passphrase != NULL && scratch != NULL &&
+		server_passphrase_hash(scratch->phash, passphrase, passlen, cpucost, memcost, &scratch->sscb) == true)
+	{
+		res = (qsc_intutils_verify(scratch->phash, phash, SIAP_HASH_SIZE) == 0U);
+		qsc_memutils_secure_erase(scratch->phash, SIAP_HASH_SIZE);
+	}
+
+	return res;
+}
+
+siap_server_scratch* siap_server_scratch_create(void)
+{
+	siap_server_scratch* scratch;
+
+	scratch = (siap_server_scratch*)qsc_memutils_aligned_alloc((int32_t)SIAP_SERVER_SCRATCH_ALIGNMENT, sizeof(siap_server_scratch));
+
+	if (scratch != NULL)
+	{
+		qsc_memutils_clear(scratch, sizeof(siap_server_scratch));
+	}
+
+	return scratch;
+}
+
+void siap_server_scratch_dispose(siap_server_scratch* scratch)
+{
+	if (scratch != NULL)
+	{
+		qsc_memutils_secure_erase(scratch, sizeof(siap_server_scratch));
+		qsc_memutils_aligned_free(scratch);
+	}
+}
+
+siap_errors siap_server_screen_device(const siap_device_key* dkey, const siap_device_tag* dtag, const siap_server_prepared_key* pkey)
+{
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(dtag != NULL);
+	SIAP_ASSERT(pkey != NULL);
+
+	siap_errors err;
+
+	if (dkey != NULL && dtag != NULL && pkey != NULL)
+	{
+		err = server_screen_device(dkey->kid, dkey->expiration, dtag, pkey);
+	}
+	else
+	{
+		err = siap_error_invalid_input;
+	}
+
+	return err;
+}
+
+void siap_server_update_device_tag(siap_device_tag* dtag, const siap_device_key* dkey)
+{
+	SIAP_ASSERT(dtag != NULL);
+	SIAP_ASSERT(dkey != NULL);
+
+	server_key_tree tree;
+
+	if (dtag != NULL && dkey != NULL)
+	{
+		server_tree_device(&tree, dkey);
+		server_tree_update(dtag, &tree);
+	}
+}
+
 bool siap_server_verify_device_tag(siap_device_tag* dtag, const siap_device_key* dkey)
 {
 	SIAP_ASSERT(dtag != NULL);
 	SIAP_ASSERT(dkey != NULL);
 
 	uint8_t tmph[SIAP_KTAG_STATE_HASH] = { 0U };
+	server_key_tree tree;
 	bool res;
 
 	res = false;
 
 	if (dtag != NULL && dkey != NULL)
 	{
-		/* hash the entire key tree and add it to khash */
-#if defined(SIAP_EXTENDED_ENCRYPTION)
-		qsc_shake512_compute(tmph, SIAP_KTAG_STATE_HASH, dkey->ktree, SIAP_KTREE_SIZE);
-#else
-		qsc_shake256_compute(tmph, SIAP_KTAG_STATE_HASH, dkey->ktree, SIAP_KTREE_SIZE);
-#endif
-
-		res = (qsc_intutils_verify(tmph, dtag->khash, SIAP_KTAG_STATE_HASH) == 0U);
+		server_tree_device(&tree, dkey);
+		res = server_tree_verify(dtag, &tree, tmph);
 	}
 
 	return res;
 }
+
+siap_errors siap_server_verify_ticket(const siap_session_ticket* ticket, const siap_device_tag* dtag, const siap_server_prepared_key* pkey)
+{
+	SIAP_ASSERT(ticket != NULL);
+	SIAP_ASSERT(dtag != NULL);
+	SIAP_ASSERT(pkey != NULL);
+
+	siap_cshake_encoded tenc;
+	uint8_t stok[SIAP_AUTHENTICATION_TOKEN_SIZE] = { 0U };
+	uint8_t tmac[SIAP_MAC_SIZE] = { 0U };
+	uint64_t tnow;
+	uint32_t kidx;
+	siap_errors err;
+
+	err = siap_error_invalid_input;
+
+	if (ticket != NULL && dtag != NULL && pkey != NULL)
+	{
+		tnow = qsc_timestamp_epochtime_seconds();
+		kidx = qsc_intutils_be8to32(dtag->kid + SIAP_DID_SIZE);
+
+		/* the lifetime is bound by the issue time in the mac, not by the verifier's clock */
+		if (ticket->issued > tnow ||
+			ticket->expiration <= tnow ||
+			ticket->expiration < ticket->issued ||
+			ticket->expiration - ticket->issued > SIAP_TICKET_DURATION_MAX ||
+			ticket->expiration > pkey->skey.expiration)
+		{
+			err = siap_error_key_expired;
+		}
+		else if (kidx == 0U ||
+			qsc_memutils_are_equal(ticket->kid, dtag->kid, SIAP_DID_SIZE) == false ||
+			qsc_intutils_be8to32(ticket->kid + SIAP_DID_SIZE) != kidx - 1U)
+		{
+			/* only the token the tag spent last can carry a ticket, a later authentication retires it */
+			err = siap_error_token_invalid;
+		}
+		else
+		{
+			/* the spent token is derived again from the server key, no device key or tree is read */
+			server_derive_token(stok, &tenc, pkey, ticket->kid);
+			server_ticket_mac(tmac, ticket, stok, pkey);
+			err = (qsc_intutils_verify(tmac, ticket->mac, SIAP_MAC_SIZE) == 0U) ? siap_error_none : siap_error_authentication_failure;
+
+			qsc_memutils_secure_erase(&tenc, sizeof(tenc));
+			qsc_memutils_secure_erase(stok, sizeof(stok));
+		}
+	}
+
+	return err;
+}
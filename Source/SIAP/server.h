@@ -53,12 +53,56 @@
 #define SIAP_SERVER_H
 
 #include "siap.h"
+#include "keccakx.h"
+#include "khash.h"
+#include "rcs.h"
+#include "scb.h"
 
 /**
 * \file server.h
 * \brief SIAP Server functions.
 */
 
+/*!
+ * \struct siap_server_prepared_key
+ * \brief The SIAP prepared server key structure.
+ * This structure contains a copy of the server key and the pre-encoded cSHAKE inputs used for token, key-tree,
+ * and device key cipher derivations. Each derivation copies the encoded input, writes the key identity
+ * (and the passphrase hash for the cipher key), and hashes it, instead of re-encoding the server key and customization.
+ */
+SIAP_EXPORT_API typedef struct siap_server_prepared_key
+{
+	siap_server_key skey;						/*!< The server key */
+	siap_cshake_encoded ktoken;					/*!< The encoded token input: kbase key, configuration name, kid customization */
+	siap_cshake_encoded kcipher;				/*!< The encoded cipher input: passphrase hash key, kid name, dsalt customization */
+} siap_server_prepared_key;
+
+/*!
+* \def SIAP_SERVER_SCRATCH_ALIGNMENT
+* \brief The alignment of a scratch workspace created by \c siap_server_scratch_create, a cache line.
+*/
+#define SIAP_SERVER_SCRATCH_ALIGNMENT 64U
+
+/*!
+ * \struct siap_server_scratch
+ * \brief The server authentication scratch workspace.
+ * Holds every temporary of an authentication, so the call itself uses little stack.
+ * The workspace is erased once when the call completes, and may be reused by the next call on the same thread.
+ * The passphrase hash functions taking a scratch workspace run their SCB state in it; the SCB memory-hard cache itself
+ * is allocated and freed by QSC inside every hash, and cannot be supplied or reused by the caller.
+ */
+SIAP_EXPORT_API typedef struct siap_server_scratch
+{
+	siap_khash_state kstate;					/*!< The key tree hash state */
+	qsc_rcs_state rstate;						/*!< The key tree cipher state */
+	siap_cshake_encoded cenc;					/*!< The cipher key and token derivation input */
+	uint8_t ckey[SIAP_SERVER_KEY_SIZE + SIAP_NONCE_SIZE];	/*!< The derived cipher key and nonce */
+	uint8_t stok[SIAP_AUTHENTICATION_TOKEN_SIZE];	/*!< The server generated token */
+	uint8_t tmph[SIAP_KTAG_STATE_HASH];			/*!< The computed key tree hash */
+	qsc_scb_state sscb;							/*!< The passphrase hash SCB state */
+	uint8_t phash[SIAP_HASH_SIZE];				/*!< The computed passphrase hash */
+} siap_server_scratch;
+
 /**
  * \brief Authenticate a device.
  * This function hashes a passphrase, decrypts a device keys token-tree, gets the next authentication token,
@@ -72,6 +116,106 @@
  */
 SIAP_EXPORT_API siap_errors siap_server_authenticate_device(uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const siap_server_key* skey, const uint8_t* phash);
 
+/**
+ * \brief Authenticate a device using a prepared server key.
+ * This function is equivalent to \c siap_server_authenticate_device, using the cached server key encodings.
+ *
+ * \param dtok The pointer to the output device token.
+ * \param dkey The pointer to the device key.
+ * \param dtag The pointer to the device tag.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The user passphrase hash.
+ */
+SIAP_EXPORT_API siap_errors siap_server_authenticate_device_prepared(uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash);
+
+/**
+ * \brief Authenticate a device using a prepared server key and a caller scratch workspace.
+ * This function is equivalent to \c siap_server_authenticate_device_prepared, with its temporaries in the workspace.
+ *
+ * \param dtok The pointer to the output device token.
+ * \param dkey The pointer to the device key.
+ * \param dtag The pointer to the device tag.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The user passphrase hash.
+ * \param scratch The scratch workspace, erased on return.
+ */
+SIAP_EXPORT_API siap_errors siap_server_authenticate_device_scratch(uint8_t* dtok, siap_device_key* dkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch);
+
+/**
+ * \brief Authenticate a device using a segmented device key.
+ * This function verifies the tag commitment to the active segment, decrypts only that segment, extracts the next token,
+ * and authenticates the device. The segment is re-encrypted under the new counter value and the tag is committed to
+ * the segment holding the next token.
+ * If the token taken is the last in its segment, the next segment must also be loaded, so that the tag can commit to it.
+ *
+ * \param dtok The pointer to the output device token.
+ * \param dkey The pointer to the segmented device key.
+ * \param dtag The pointer to the device tag.
+ * \param skey [const] The input server derivation key.
+ * \param phash [const] The user passphrase hash.
+ */
+SIAP_EXPORT_API siap_errors siap_server_authenticate_segmented_key(uint8_t* dtok, siap_segmented_key* dkey, siap_device_tag* dtag, const siap_server_key* skey, const uint8_t* phash);
+
+/**
+ * \brief Authenticate a device using a segmented device key and a prepared server key.
+ * This function is equivalent to \c siap_server_authenticate_segmented_key, using the cached server key encodings.
+ *
+ * \param dtok The pointer to the output device token.
+ * \param dkey The pointer to the segmented device key.
+ * \param dtag The pointer to the device tag.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The user passphrase hash.
+ */
+SIAP_EXPORT_API siap_errors siap_server_authenticate_segmented_key_prepared(uint8_t* dtok, siap_segmented_key* dkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash);
+
+/**
+ * \brief Authenticate a device using a segmented device key, a prepared server key, and a caller scratch workspace.
+ * This function is equivalent to \c siap_server_authenticate_segmented_key_prepared, with its temporaries in the workspace.
+ *
+ * \param dtok The pointer to the output device token.
+ * \param dkey The pointer to the segmented device key.
+ * \param dtag The pointer to the device tag.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The user passphrase hash.
+ * \param scratch The scratch workspace, erased on return.
+ */
+SIAP_EXPORT_API siap_errors siap_server_authenticate_segmented_key_scratch(uint8_t* dtok, siap_segmented_key* dkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch);
+
+/**
+ * \brief Authenticate a device using a variable-size device key.
+ * This function is equivalent to \c siap_server_authenticate_device, for a key tree of any supported size.
+ *
+ * \param dtok The pointer to the output device token.
+ * \param vkey The pointer to the variable-size device key.
+ * \param dtag The pointer to the device tag.
+ * \param skey [const] The input server derivation key.
+ * \param phash [const] The user passphrase hash.
+ */
+SIAP_EXPORT_API siap_errors siap_server_authenticate_variable_key(uint8_t* dtok, siap_variable_key* vkey, siap_device_tag* dtag, const siap_server_key* skey, const uint8_t* phash);
+
+/**
+ * \brief Authenticate a device using a variable-size device key and a prepared server key.
+ *
+ * \param dtok The pointer to the output device token.
+ * \param vkey The pointer to the variable-size device key.
+ * \param dtag The pointer to the device tag.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The user passphrase hash.
+ */
+SIAP_EXPORT_API siap_errors siap_server_authenticate_variable_key_prepared(uint8_t* dtok, siap_variable_key* vkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash);
+
+/**
+ * \brief Authenticate a device using a variable-size device key, a prepared server key, and a caller scratch workspace.
+ *
+ * \param dtok The pointer to the output device token.
+ * \param vkey The pointer to the variable-size device key.
+ * \param dtag The pointer to the device tag.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The user passphrase hash.
+ * \param scratch The scratch workspace, erased on return.
+ */
+SIAP_EXPORT_API siap_errors siap_server_authenticate_variable_key_scratch(uint8_t* dtok, siap_variable_key* vkey, siap_device_tag* dtag, const siap_server_prepared_key* pkey, const uint8_t* phash, siap_server_scratch* scratch);
+
 /**
  * \brief Decrypt a device key.
  * This function decrypts a device keys token-tree.
@@ -82,6 +226,34 @@ SIAP_EXPORT_API siap_errors siap_server_authenticate_device(uint8_t* dtok, siap_
  */
 SIAP_EXPORT_API bool siap_server_decrypt_device_key(siap_device_key* dkey, const siap_server_key* skey, const uint8_t* phash);
 
+/**
+ * \brief Decrypt a device key using a prepared server key.
+ *
+ * \param dkey The pointer to the output device key.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The passphrase hash.
+ */
+SIAP_EXPORT_API bool siap_server_decrypt_device_key_prepared(siap_device_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* phash);
+
+/**
+ * \brief Decrypt a variable-size device key.
+ * The token count is bound to the cipher, so a key whose header count was altered fails authentication.
+ *
+ * \param vkey The pointer to the variable-size device key.
+ * \param skey [const] The input server derivation key.
+ * \param phash [const] The passphrase hash.
+ */
+SIAP_EXPORT_API bool siap_server_decrypt_variable_key(siap_variable_key* vkey, const siap_server_key* skey, const uint8_t* phash);
+
+/**
+ * \brief Decrypt a variable-size device key using a prepared server key.
+ *
+ * \param vkey The pointer to the variable-size device key.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The passphrase hash.
+ */
+SIAP_EXPORT_API bool siap_server_decrypt_variable_key_prepared(siap_variable_key* vkey, const siap_server_prepared_key* pkey, const uint8_t* phash);
+
 /**
  * \brief Encrypt a device key.
  * This function encrypts a device keys token-tree.
@@ -92,6 +264,52 @@ SIAP_EXPORT_API bool siap_server_decrypt_device_key(siap_device_key* dkey, const
  */
 SIAP_EXPORT_API void siap_server_encrypt_device_key(siap_device_key* dkey, const siap_server_key* skey, const uint8_t* phash);
 
+/**
+ * \brief Encrypt a device key using a prepared server key.
+ *
+ * \param dkey The pointer to the output device key.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The passphrase hash.
+ */
+SIAP_EXPORT_API void siap_server_encrypt_device_key_prepared(siap_device_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* phash);
+
+/**
+ * \brief Encrypt a segmented device key.
+ * This function encrypts each segment of the token set independently, under the current counter value and the segment index.
+ *
+ * \param dkey The pointer to the output segmented device key.
+ * \param skey [const] The input server derivation key.
+ * \param phash [const] The passphrase hash.
+ */
+SIAP_EXPORT_API void siap_server_encrypt_segmented_key(siap_segmented_key* dkey, const siap_server_key* skey, const uint8_t* phash);
+
+/**
+ * \brief Encrypt a segmented device key using a prepared server key.
+ *
+ * \param dkey The pointer to the output segmented device key.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The passphrase hash.
+ */
+SIAP_EXPORT_API void siap_server_encrypt_segmented_key_prepared(siap_segmented_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* phash);
+
+/**
+ * \brief Encrypt a variable-size device key.
+ *
+ * \param vkey The pointer to the variable-size device key.
+ * \param skey [const] The input server derivation key.
+ * \param phash [const] The passphrase hash.
+ */
+SIAP_EXPORT_API void siap_server_encrypt_variable_key(siap_variable_key* vkey, const siap_server_key* skey, const uint8_t* phash);
+
+/**
+ * \brief Encrypt a variable-size device key using a prepared server key.
+ *
+ * \param vkey The pointer to the variable-size device key.
+ * \param pkey [const] The prepared server key.
+ * \param phash [const] The passphrase hash.
+ */
+SIAP_EXPORT_API void siap_server_encrypt_variable_key_prepared(siap_variable_key* vkey, const siap_server_prepared_key* pkey, const uint8_t* phash);
+
 /**
  * \brief Extract an authentication token.
  * This function extracts an authentication token and erases it on the tree.
@@ -112,6 +330,15 @@ SIAP_EXPORT_API bool siap_server_extract_authentication_token(uint8_t* token, si
  */
 SIAP_EXPORT_API bool siap_server_generate_authentication_token(uint8_t* token, const siap_device_tag* dtag, const siap_server_key* skey);
 
+/**
+ * \brief Generate an authentication token using a prepared server key.
+ *
+ * \param token The output authentication token.
+ * \param dtag [const] The input device tag.
+ * \param pkey [const] The prepared server key.
+ */
+SIAP_EXPORT_API bool siap_server_generate_authentication_token_prepared(uint8_t* token, const siap_device_tag* dtag, const siap_server_prepared_key* pkey);
+
 /**
  * \brief Generate a device key.
  * This function generates a new SIAP device key using the provided server key.
@@ -123,10 +350,21 @@ SIAP_EXPORT_API bool siap_server_generate_authentication_token(uint8_t* token, c
  */
 SIAP_EXPORT_API void siap_server_generate_device_key(siap_device_key* dkey, const siap_server_key* skey, const uint8_t* did);
 
+/**
+ * \brief Generate a device key using a prepared server key.
+ *
+ * \param dkey A pointer to the SIAP device key structure.
+ * \param pkey [const] The prepared server key.
+ * \param did [const] The key identity array.
+ */
+SIAP_EXPORT_API void siap_server_generate_device_key_prepared(siap_device_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* did);
+
 /**
  * \brief Generate a device tag.
  * This function generates a new SIAP device tag structure.
  * It populates the provided device tag structure with the device key identity array and a hash of the device key..
+ * The key tree is hashed in the mode set in the tag \c kmode field; a zeroed tag uses the serial mode.
+ * A mac commitment mode tag commits to the encrypted key, so the key must be encrypted before the tag is generated.
  *
  * \param dtag A pointer to the SIAP device tag structure.
  * \param dkey [const] A pointer to the device key.
@@ -134,6 +372,68 @@ SIAP_EXPORT_API void siap_server_generate_device_key(siap_device_key* dkey, cons
  */
 SIAP_EXPORT_API void siap_server_generate_device_tag(siap_device_tag* dtag, const siap_device_key* dkey, const uint8_t* phash);
 
+/**
+ * \brief Generate a segmented device key.
+ * This function generates the same token set as \c siap_server_generate_device_key,
+ * split into fixed size segments that can be stored and encrypted independently.
+ *
+ * \param dkey A pointer to the SIAP segmented device key structure.
+ * \param skey [const] A pointer to the server key.
+ * \param did [const] The device identity array.
+ */
+SIAP_EXPORT_API void siap_server_generate_segmented_key(siap_segmented_key* dkey, const siap_server_key* skey, const uint8_t* did);
+
+/**
+ * \brief Generate a segmented device key using a prepared server key.
+ *
+ * \param dkey A pointer to the SIAP segmented device key structure.
+ * \param pkey [const] A pointer to the prepared server key.
+ * \param did [const] The device identity array.
+ */
+SIAP_EXPORT_API void siap_server_generate_segmented_key_prepared(siap_segmented_key* dkey, const siap_server_prepared_key* pkey, const uint8_t* did);
+
+/**
+ * \brief Generate a device tag for a segmented device key.
+ * This function sets the tag to the segment mode, and commits the tag to the mac of the active segment.
+ * The segmented key must be encrypted before the tag is generated.
+ *
+ * \param dtag A pointer to the SIAP device tag structure.
+ * \param dkey [const] A pointer to the encrypted segmented device key.
+ * \param phash A pointer to the passphrase hash.
+ */
+SIAP_EXPORT_API void siap_server_generate_segmented_tag(siap_device_tag* dtag, const siap_segmented_key* dkey, const uint8_t* phash);
+
+/**
+ * \brief Generate a variable-size device key.
+ * The key must first be initialized with \c siap_variable_key_initialize, which sets the number of tokens generated.
+ *
+ * \param vkey A pointer to the initialized variable-size device key.
+ * \param skey [const] A pointer to the server key.
+ * \param did [const] The device identity array.
+ */
+SIAP_EXPORT_API void siap_server_generate_variable_key(siap_variable_key* vkey, const siap_server_key* skey, const uint8_t* did);
+
+/**
+ * \brief Generate a variable-size device key using a prepared server key.
+ *
+ * \param vkey A pointer to the initialized variable-size device key.
+ * \param pkey [const] A pointer to the prepared server key.
+ * \param did [const] The device identity array.
+ */
+SIAP_EXPORT_API void siap_server_generate_variable_key_prepared(siap_variable_key* vkey, const siap_server_prepared_key* pkey, const uint8_t* did);
+
+/**
+ * \brief Generate a device tag for a variable-size device key.
+ * The Merkle mode authentication path holds log2(count) hashes, so every supported tree size can use that mode.
+ *
+ * \param dtag A pointer to the SIAP device tag structure.
+ * \param vkey [const] A pointer to the variable-size device key.
+ * \param phash A pointer to the passphrase hash.
+ *
+ * \return Returns false if the tag mode cannot cover the key tree.
+ */
+SIAP_EXPORT_API bool siap_server_generate_variable_tag(siap_device_tag* dtag, const siap_variable_key* vkey, const uint8_t* phash);
+
 /**
  * \brief Generate a server key-set.
  * This function generates a new SIAP server key-set based on the provided master key. It populates the server key structure
@@ -146,6 +446,42 @@ SIAP_EXPORT_API void siap_server_generate_device_tag(siap_device_tag* dtag, cons
  */
 SIAP_EXPORT_API bool siap_server_generate_server_key(siap_server_key* skey, const uint8_t* sid);
 
+/**
+ * \brief Issue a session ticket after a successful authentication.
+ * The ticket mac key is derived from the server key together with the token the authentication returned and its kid,
+ * so only the server can issue a ticket; the mac covers the kid, the issue time, and the expiration.
+ * A ticket lets the device re-authenticate with \c siap_server_verify_ticket until it expires,
+ * without another token being spent.
+ *
+ * \param ticket A pointer to the output session ticket.
+ * \param dtok [const] The device token returned by the authentication.
+ * \param dtag [const] The device tag, as updated by the authentication.
+ * \param pkey [const] The prepared server key.
+ * \param lifetime The ticket lifetime in seconds, limited to \c SIAP_TICKET_DURATION_MAX and the server key expiration.
+ *
+ * \return Returns false if the tag has not spent a token.
+ */
+SIAP_EXPORT_API bool siap_server_issue_ticket(siap_session_ticket* ticket, const uint8_t* dtok, const siap_device_tag* dtag, const siap_server_prepared_key* pkey, uint32_t lifetime);
+
+/**
+ * \brief Prepare a server key.
+ * This function copies the server key and encodes the constant parts of the token and cipher key derivations.
+ * The prepared key is read-only after this call and may be shared between threads.
+ *
+ * \param pkey A pointer to the output prepared server key.
+ * \param skey [const] A pointer to the SIAP server key structure.
+ *
+ * \return Returns true if the key was prepared.
+ */
+SIAP_EXPORT_API bool siap_server_prepare_key(siap_server_prepared_key* pkey, const siap_server_key* skey);
+
+/**
+ * \brief Erase a prepared server key.
+ *
+ * \param pkey A pointer to the prepared server key.
+ */
+SIAP_EXPORT_API void siap_server_prepared_key_dispose(siap_server_prepared_key* pkey);
+
 /**
  * \brief Generate a readable pseudo-random passphrase.
  *
@@ -154,6 +490,41 @@ SIAP_EXPORT_API bool siap_server_generate_server_key(siap_server_key* skey, cons
  */
 SIAP_EXPORT_API void siap_server_passphrase_generate(char* passphrase, size_t length);
 
+/**
+ * \brief Generate the passphrase hashes of a batch of passphrases with the same SCB costs.
+ * The passphrases are divided between worker threads, each running one SCB instance at a time,
+ * so at most one SCB memory cost is allocated per thread. The threads stripe whole passphrases; the Keccak lanes
+ * of separate SCB instances are not interleaved with SIMD, since the SCB permutations run inside QSC.
+ * Every hash matches \c siap_server_passphrase_hash_generate_costs with the same costs.
+ *
+ * \param phashes The output passphrase hashes, \c count hashes of size \c SIAP_HASH_SIZE.
+ * \param passphrases [const] The array of passphrase pointers.
+ * \param passlens [const] The array of passphrase lengths.
+ * \param count The number of passphrases.
+ * \param cpucost The SCB CPU cost, at most \c SIAP_SCB_CPU_COST_MAX; zero selects the compiled default.
+ * \param memcost The SCB memory cost, at most \c SIAP_SCB_MEMORY_COST_MAX; zero selects the compiled default.
+ * \param threads The maximum number of threads; zero uses one thread per processor. The calling thread hashes
+ * the passphrases of any thread that could not be started.
+ *
+ * \return Returns false if a cost is out of range; the hashes are not all computed.
+ */
+SIAP_EXPORT_API bool siap_server_passphrase_hash_batch(uint8_t* phashes, const char* const* passphrases, const size_t* passlens, size_t count, size_t cpucost, size_t memcost, size_t threads);
+
+/**
+ * \brief Choose the highest SCB costs that meet a passphrase hash latency target on this host.
+ * The memory cost is raised first and the cpu cost second; each candidate is timed over \c samples hashes,
+ * and accepted if the 99th percentile time is within the target.
+ * The chosen costs can be recorded in new device tags, while existing tags keep their own costs.
+ *
+ * \param cpucost The output SCB CPU cost.
+ * \param memcost The output SCB memory cost.
+ * \param target The latency target in milliseconds.
+ * \param samples The number of hashes timed for each candidate, at most 128.
+ *
+ * \return Returns false if the lowest costs miss the target, in which case the lowest costs are returned.
+ */
+SIAP_EXPORT_API bool siap_server_passphrase_hash_calibrate(uint8_t* cpucost, uint8_t* memcost, uint32_t target, size_t samples);
+
 /**
  * \brief Generate the passphrase hash.
  *
@@ -163,6 +534,35 @@ SIAP_EXPORT_API void siap_server_passphrase_generate(char* passphrase, size_t le
  */
 SIAP_EXPORT_API void siap_server_passphrase_hash_generate(uint8_t* phash, const char* passphrase, size_t passlen);
 
+/**
+ * \brief Generate the passphrase hash with explicit SCB costs.
+ * Use the costs recorded in the device tag \c cpucost and \c memcost fields; a zero cost selects the compiled default.
+ *
+ * \param phash A pointer to the passphrase hash.
+ * \param passphrase [const] A pointer to the passphrase.
+ * \param passlen The passphrase length.
+ * \param cpucost The SCB CPU cost, at most \c SIAP_SCB_CPU_COST_MAX.
+ * \param memcost The SCB memory cost, at most \c SIAP_SCB_MEMORY_COST_MAX.
+ *
+ * \return Returns false if a cost is out of range; the hash is not computed.
+ */
+SIAP_EXPORT_API bool siap_server_passphrase_hash_generate_costs(uint8_t* phash, const char* passphrase, size_t passlen, size_t cpucost, size_t memcost);
+
+/**
+ * \brief Generate the passphrase hash with explicit SCB costs, using a scratch workspace for the SCB state.
+ * Intended for a worker thread that keeps one scratch workspace; the SCB state is erased when the hash completes.
+ *
+ * \param phash A pointer to the passphrase hash.
+ * \param passphrase [const] A pointer to the passphrase.
+ * \param passlen The passphrase length.
+ * \param cpucost The SCB CPU cost, at most \c SIAP_SCB_CPU_COST_MAX; zero selects the compiled default.
+ * \param memcost The SCB memory cost, at most \c SIAP_SCB_MEMORY_COST_MAX; zero selects the compiled default.
+ * \param scratch The caller's scratch workspace.
+ *
+ * \return Returns false if a cost is out of range; the hash is not computed.
+ */
+SIAP_EXPORT_API bool siap_server_passphrase_hash_generate_scratch(uint8_t* phash, const char* passphrase, size_t passlen, size_t cpucost, size_t memcost, siap_server_scratch* scratch);
+
 /**
  * \brief Verify a passphrase against the hash.
  *
@@ -174,8 +574,64 @@ SIAP_EXPORT_API void siap_server_passphrase_hash_generate(uint8_t* phash, const
  */
 SIAP_EXPORT_API bool siap_server_passphrase_hash_verify(const uint8_t* phash, const char* passphrase, size_t passlen);
 
+/**
+ * \brief Verify a passphrase against the hash with explicit SCB costs, using a scratch workspace for the SCB state and the hash.
+ *
+ * \param phash [const] A pointer to the passphrase hash.
+ * \param passphrase [const] A pointer to the passphrase.
+ * \param passlen The passphrase length.
+ * \param cpucost The SCB CPU cost recorded in the device tag.
+ * \param memcost The SCB memory cost recorded in the device tag.
+ * \param scratch The caller's scratch workspace.
+ *
+ * \return Returns true if the passphrase hash matches; false if it does not, or a cost is out of range.
+ */
+SIAP_EXPORT_API bool siap_server_passphrase_hash_verify_scratch(const uint8_t* phash, const char* passphrase, size_t passlen, size_t cpucost, size_t memcost, siap_server_scratch* scratch);
+
+/**
+ * \brief Allocate a cache-aligned scratch workspace.
+ *
+ * \return Returns the workspace, or NULL if it could not be allocated.
+ */
+SIAP_EXPORT_API siap_server_scratch* siap_server_scratch_create(void);
+
+/**
+ * \brief Erase and free a scratch workspace created by \c siap_server_scratch_create.
+ *
+ * \param scratch A pointer to the workspace, may be NULL.
+ */
+SIAP_EXPORT_API void siap_server_scratch_dispose(siap_server_scratch* scratch);
+
+/**
+ * \brief Screen a device before its passphrase is hashed.
+ * This function runs the inexpensive checks of an authentication, comparing the device and tag key identities, checking
+ * the expiration time and the passphrase costs recorded in the tag, so a request that would fail can be rejected before the
+ * SCB passphrase hash is computed.
+ * The authentication functions repeat these checks.
+ *
+ * \param dkey [const] The pointer to the device key.
+ * \param dtag [const] The pointer to the device tag.
+ * \param pkey [const] The prepared server key.
+ *
+ * \return Returns \c siap_error_none if the device passed, or the error the authentication would return.
+ */
+SIAP_EXPORT_API siap_errors siap_server_screen_device(const siap_device_key* dkey, const siap_device_tag* dtag, const siap_server_prepared_key* pkey);
+
+/**
+ * \brief Update a device tag after a token has been extracted from the device key.
+ * A Merkle mode tag that is one token behind the key has its root and path moved to the next token,
+ * recomputing only the affected path; a mac commitment mode tag is committed to the encrypted key;
+ * any other tag is regenerated from the full key tree.
+ *
+ * \param dtag A pointer to the SIAP device tag structure.
+ * \param dkey [const] A pointer to the device key.
+ */
+SIAP_EXPORT_API void siap_server_update_device_tag(siap_device_tag* dtag, const siap_device_key* dkey);
+
 /**
  * \brief Hash the key tree and compare it with the value stored in the device tag.
+ * A Merkle mode tag only verifies the current token against the stored root and authentication path,
+ * and a mac commitment mode tag is compared with the mac of the encrypted key.
  *
  * \param dtag A pointer to the SIAP device tag structure.
  * \param dkey [const] A pointer to the device key.
@@ -184,4 +640,19 @@ SIAP_EXPORT_API bool siap_server_passphrase_hash_verify(const uint8_t* phash, co
  */
 SIAP_EXPORT_API bool siap_server_verify_device_tag(siap_device_tag* dtag, const siap_device_key* dkey);
 
+/**
+ * \brief Verify a session ticket.
+ * The token the ticket was issued for is derived again from the server key, and keys a single mac check;
+ * the device key is not used. The ticket must be for the token the device tag spent last, so a ticket is retired
+ * by the next authentication, and its lifetime, from its issue time to its expiration, must not exceed \c SIAP_TICKET_DURATION_MAX.
+ *
+ * \param ticket [const] A pointer to the session ticket.
+ * \param dtag [const] The current device tag.
+ * \param pkey [const] The prepared server key.
+ *
+ * \return Returns \c siap_error_none if the ticket is valid, \c siap_error_key_expired if it has expired or is not yet valid,
+ * \c siap_error_token_invalid if it is not for the tag's last spent token, or \c siap_error_authentication_failure if the mac does not match.
+ */
+SIAP_EXPORT_API siap_errors siap_server_verify_ticket(const siap_session_ticket* ticket, const siap_device_tag* dtag, const siap_server_prepared_key* pkey);
+
 #endif
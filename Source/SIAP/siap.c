@@ -38,38 +38,367 @@ void siap_serialize_device_key(uint8_t* output, const siap_device_key* dkey)
 	}
 }
 
-void siap_deserialize_device_tag(siap_device_tag* dtag, const uint8_t* input)
+void siap_deserialize_key_segment(siap_key_segment* segment, const uint8_t* input)
+{
+	SIAP_ASSERT(segment != NULL);
+	SIAP_ASSERT(input != NULL);
+
+	if (segment != NULL && input != NULL)
+	{
+		segment->sequence = qsc_intutils_le8to32(input);
+		qsc_memutils_copy(segment->stree, input + SIAP_KSEGMENT_SEQUENCE_SIZE, SIAP_KSEGMENT_SIZE + SIAP_MAC_SIZE);
+	}
+}
+
+void siap_serialize_key_segment(uint8_t* output, const siap_key_segment* segment)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(segment != NULL);
+
+	if (output != NULL && segment != NULL)
+	{
+		qsc_intutils_le32to8(output, segment->sequence);
+		qsc_memutils_copy(output + SIAP_KSEGMENT_SEQUENCE_SIZE, segment->stree, SIAP_KSEGMENT_SIZE + SIAP_MAC_SIZE);
+	}
+}
+
+bool siap_deserialize_segmented_key(siap_segmented_key* dkey, const uint8_t* input)
+{
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(input != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (dkey != NULL && input != NULL)
+	{
+		res = siap_deserialize_segmented_key_header(dkey, input);
+
+		if (res == true)
+		{
+			for (size_t i = 0U; i < SIAP_KSEGMENT_COUNT; ++i)
+			{
+				siap_deserialize_key_segment(&dkey->segments[i], input + SIAP_SEGMENTED_HEADER_ENCODED_SIZE + (i * SIAP_KSEGMENT_ENCODED_SIZE));
+			}
+		}
+	}
+
+	return res;
+}
+
+void siap_serialize_segmented_key(uint8_t* output, const siap_segmented_key* dkey)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(dkey != NULL);
+
+	if (output != NULL && dkey != NULL)
+	{
+		siap_serialize_segmented_key_header(output, dkey);
+
+		for (size_t i = 0U; i < SIAP_KSEGMENT_COUNT; ++i)
+		{
+			siap_serialize_key_segment(output + SIAP_SEGMENTED_HEADER_ENCODED_SIZE + (i * SIAP_KSEGMENT_ENCODED_SIZE), &dkey->segments[i]);
+		}
+	}
+}
+
+bool siap_deserialize_segmented_key_header(siap_segmented_key* dkey, const uint8_t* input)
+{
+	SIAP_ASSERT(dkey != NULL);
+	SIAP_ASSERT(input != NULL);
+
+	size_t pos;
+	bool res;
+
+	res = false;
+
+	if (dkey != NULL && input != NULL && input[0U] == (uint8_t)siap_card_format_segmented)
+	{
+		pos = SIAP_CARD_FORMAT_SIZE;
+		qsc_memutils_copy(dkey->kid, input + pos, SIAP_KID_SIZE);
+		pos += SIAP_KID_SIZE;
+		dkey->expiration = qsc_intutils_le8to64(input + pos);
+		res = true;
+	}
+
+	return res;
+}
+
+void siap_serialize_segmented_key_header(uint8_t* output, const siap_segmented_key* dkey)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(dkey != NULL);
+
+	size_t pos;
+
+	if (output != NULL && dkey != NULL)
+	{
+		output[0U] = (uint8_t)siap_card_format_segmented;
+		pos = SIAP_CARD_FORMAT_SIZE;
+		qsc_memutils_copy(output + pos, dkey->kid, SIAP_KID_SIZE);
+		pos += SIAP_KID_SIZE;
+		qsc_intutils_le64to8(output + pos, dkey->expiration);
+	}
+}
+
+bool siap_deserialize_variable_key(siap_variable_key* vkey, const uint8_t* input, size_t inplen)
+{
+	SIAP_ASSERT(vkey != NULL);
+	SIAP_ASSERT(input != NULL);
+
+	uint32_t count;
+	bool res;
+
+	res = false;
+
+	if (vkey != NULL && input != NULL && inplen >= SIAP_VARIABLE_HEADER_ENCODED_SIZE && input[0U] == (uint8_t)siap_card_format_variable)
+	{
+		count = qsc_intutils_le8to32(input + SIAP_CARD_FORMAT_SIZE);
+
+		if (inplen == siap_variable_key_encoded_size(count) && siap_variable_key_initialize(vkey, count) == true)
+		{
+			res = siap_deserialize_variable_key_buffer(vkey, vkey->ktree, count, input, inplen);
+		}
+	}
+
+	return res;
+}
+
+bool siap_deserialize_variable_key_buffer(siap_variable_key* vkey, uint8_t* ktree, uint32_t capacity, const uint8_t* input, size_t inplen)
+{
+	SIAP_ASSERT(vkey != NULL);
+	SIAP_ASSERT(ktree != NULL);
+	SIAP_ASSERT(input != NULL);
+
+	size_t pos;
+	uint32_t count;
+	bool res;
+
+	res = false;
+
+	if (vkey != NULL && ktree != NULL && input != NULL && inplen >= SIAP_VARIABLE_HEADER_ENCODED_SIZE && input[0U] == (uint8_t)siap_card_format_variable)
+	{
+		count = qsc_intutils_le8to32(input + SIAP_CARD_FORMAT_SIZE);
+
+		/* the count must be a power of two so the Merkle mode can cover the tree */
+		if (count >= SIAP_KTREE_COUNT_MIN && count <= SIAP_KTREE_COUNT_MAX && count <= capacity && (count & (count - 1U)) == 0U &&
+			inplen == siap_variable_key_encoded_size(count))
+		{
+			vkey->ktree = ktree;
+			vkey->kcount = count;
+			pos = SIAP_CARD_FORMAT_SIZE + SIAP_KTREE_COUNT_SIZE;
+			qsc_memutils_copy(vkey->kid, input + pos, SIAP_KID_SIZE);
+			pos += SIAP_KID_SIZE;
+			vkey->expiration = qsc_intutils_le8to64(input + pos);
+			pos += SIAP_EXPIRATION_SIZE;
+			qsc_memutils_copy(vkey->ktree, input + pos, ((size_t)count * SIAP_AUTHENTICATION_TOKEN_SIZE) + SIAP_MAC_SIZE);
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+void siap_serialize_variable_key(uint8_t* output, const siap_variable_key* vkey)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(vkey != NULL);
+
+	size_t pos;
+
+	if (output != NULL && vkey != NULL && vkey->ktree != NULL)
+	{
+		output[0U] = (uint8_t)siap_card_format_variable;
+		pos = SIAP_CARD_FORMAT_SIZE;
+		qsc_intutils_le32to8(output + pos, vkey->kcount);
+		pos += SIAP_KTREE_COUNT_SIZE;
+		qsc_memutils_copy(output + pos, vkey->kid, SIAP_KID_SIZE);
+		pos += SIAP_KID_SIZE;
+		qsc_intutils_le64to8(output + pos, vkey->expiration);
+		pos += SIAP_EXPIRATION_SIZE;
+		qsc_memutils_copy(output + pos, vkey->ktree, ((size_t)vkey->kcount * SIAP_AUTHENTICATION_TOKEN_SIZE) + SIAP_MAC_SIZE);
+	}
+}
+
+void siap_variable_key_dispose(siap_variable_key* vkey)
+{
+	SIAP_ASSERT(vkey != NULL);
+
+	if (vkey != NULL)
+	{
+		if (vkey->ktree != NULL)
+		{
+			qsc_memutils_secure_erase(vkey->ktree, ((size_t)vkey->kcount * SIAP_AUTHENTICATION_TOKEN_SIZE) + SIAP_MAC_SIZE);
+			qsc_memutils_alloc_free(vkey->ktree);
+			vkey->ktree = NULL;
+		}
+
+		qsc_memutils_secure_erase(vkey->kid, SIAP_KID_SIZE);
+		vkey->kcount = 0U;
+		vkey->expiration = 0U;
+	}
+}
+
+size_t siap_variable_key_encoded_size(uint32_t count)
+{
+	return SIAP_VARIABLE_HEADER_ENCODED_SIZE + ((size_t)count * SIAP_AUTHENTICATION_TOKEN_SIZE) + SIAP_MAC_SIZE;
+}
+
+bool siap_variable_key_initialize(siap_variable_key* vkey, uint32_t count)
+{
+	SIAP_ASSERT(vkey != NULL);
+
+	size_t tlen;
+	bool res;
+
+	res = false;
+
+	/* the count must be a power of two so the Merkle mode can cover the tree */
+	if (vkey != NULL && count >= SIAP_KTREE_COUNT_MIN && count <= SIAP_KTREE_COUNT_MAX && (count & (count - 1U)) == 0U)
+	{
+		tlen = ((size_t)count * SIAP_AUTHENTICATION_TOKEN_SIZE) + SIAP_MAC_SIZE;
+		vkey->ktree = (uint8_t*)qsc_memutils_malloc(tlen);
+
+		if (vkey->ktree != NULL)
+		{
+			qsc_memutils_clear(vkey->ktree, tlen);
+			qsc_memutils_clear(vkey->kid, SIAP_KID_SIZE);
+			vkey->kcount = count;
+			vkey->expiration = 0U;
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+bool siap_deserialize_device_tag(siap_device_tag* dtag, const uint8_t* input, size_t inplen)
 {
 	SIAP_ASSERT(dtag != NULL);
 	SIAP_ASSERT(input != NULL);
 
 	size_t pos;
+	bool res;
+
+	res = false;
 
 	if (dtag != NULL && input != NULL)
 	{
-		qsc_memutils_copy(dtag->kid, input, SIAP_KID_SIZE);
-		pos = SIAP_KID_SIZE;
-		qsc_memutils_copy(dtag->khash, input + pos, SIAP_KTAG_STATE_HASH);
-		pos += SIAP_KTAG_STATE_HASH;
-		qsc_memutils_copy(dtag->phash, input + pos, SIAP_HASH_SIZE);
+		qsc_memutils_clear(dtag, sizeof(siap_device_tag));
+
+		if (inplen == SIAP_DEVICE_TAG_ORIGINAL_SIZE)
+		{
+			/* an original tag predates the hash modes and the runtime passphrase costs */
+			dtag->kmode = siap_khash_mode_serial;
+			pos = 0U;
+			res = true;
+		}
+		else if (inplen >= SIAP_TAG_FORMAT_SIZE + SIAP_KHASH_MODE_SIZE + SIAP_SCB_COST_SIZE + SIAP_DEVICE_TAG_ORIGINAL_SIZE && 
+			input[0U] == (uint8_t)siap_tag_format_versioned && 
+			input[SIAP_TAG_FORMAT_SIZE] <= (uint8_t)siap_khash_mode_commitment)
+		{
+			pos = SIAP_TAG_FORMAT_SIZE;
+			dtag->kmode = (siap_khash_modes)input[pos];
+			pos += SIAP_KHASH_MODE_SIZE;
+			dtag->cpucost = input[pos];
+			dtag->memcost = input[pos + 1U];
+			pos += SIAP_SCB_COST_SIZE;
+
+			/* the Merkle path depth follows the original fields */
+			if (dtag->kmode == siap_khash_mode_merkle && inplen > pos + SIAP_DEVICE_TAG_ORIGINAL_SIZE)
+			{
+				dtag->kdepth = input[pos + SIAP_DEVICE_TAG_ORIGINAL_SIZE];
+			}
+
+			/* the passphrase costs are bounded, so a corrupt or crafted tag cannot demand an arbitrary SCB cost */
+			res = (dtag->cpucost <= SIAP_SCB_CPU_COST_MAX && dtag->memcost <= SIAP_SCB_MEMORY_COST_MAX &&
+				dtag->kdepth <= SIAP_KTREE_DEPTH_MAX && inplen == siap_device_tag_encoded_size(dtag));
+		}
+
+		if (res == true)
+		{
+			qsc_memutils_copy(dtag->kid, input + pos, SIAP_KID_SIZE);
+			pos += SIAP_KID_SIZE;
+			qsc_memutils_copy(dtag->khash, input + pos, SIAP_KTAG_STATE_HASH);
+			pos += SIAP_KTAG_STATE_HASH;
+			qsc_memutils_copy(dtag->phash, input + pos, SIAP_HASH_SIZE);
+			pos += SIAP_HASH_SIZE;
+
+			if (dtag->kdepth != 0U)
+			{
+				pos += SIAP_KHASH_DEPTH_SIZE;
+				qsc_memutils_copy(dtag->kpath, input + pos, (size_t)dtag->kdepth * SIAP_KTAG_STATE_HASH);
+			}
+		}
+		else
+		{
+			qsc_memutils_clear(dtag, sizeof(siap_device_tag));
+		}
 	}
+
+	return res;
 }
 
-void siap_serialize_device_tag(uint8_t* output, const siap_device_tag* dtag)
+size_t siap_device_tag_encoded_size(const siap_device_tag* dtag)
+{
+	SIAP_ASSERT(dtag != NULL);
+
+	size_t res;
+
+	res = 0U;
+
+	if (dtag != NULL)
+	{
+		res = SIAP_TAG_FORMAT_SIZE + SIAP_KHASH_MODE_SIZE + SIAP_SCB_COST_SIZE + SIAP_DEVICE_TAG_ORIGINAL_SIZE;
+
+		/* only a Merkle tag carries a path, of log2(count) hashes */
+		if (dtag->kmode == siap_khash_mode_merkle)
+		{
+			res += SIAP_KHASH_DEPTH_SIZE + ((size_t)qsc_intutils_min(dtag->kdepth, SIAP_KTREE_DEPTH_MAX) * SIAP_KTAG_STATE_HASH);
+		}
+	}
+
+	return res;
+}
+
+size_t siap_serialize_device_tag(uint8_t* output, const siap_device_tag* dtag)
 {
 	SIAP_ASSERT(output != NULL);
 	SIAP_ASSERT(dtag != NULL);
 
+	size_t plen;
 	size_t pos;
 
+	pos = 0U;
+
 	if (output != NULL && dtag != NULL)
 	{
-		qsc_memutils_copy(output, dtag->kid, SIAP_KID_SIZE);
-		pos = SIAP_KID_SIZE;
+		output[0U] = (uint8_t)siap_tag_format_versioned;
+		pos = SIAP_TAG_FORMAT_SIZE;
+		output[pos] = (uint8_t)dtag->kmode;
+		pos += SIAP_KHASH_MODE_SIZE;
+		output[pos] = dtag->cpucost;
+		output[pos + 1U] = dtag->memcost;
+		pos += SIAP_SCB_COST_SIZE;
+		qsc_memutils_copy(output + pos, dtag->kid, SIAP_KID_SIZE);
+		pos += SIAP_KID_SIZE;
 		qsc_memutils_copy(output + pos, dtag->khash, SIAP_KTAG_STATE_HASH);
 		pos += SIAP_KTAG_STATE_HASH;
 		qsc_memutils_copy(output + pos, dtag->phash, SIAP_HASH_SIZE);
+		pos += SIAP_HASH_SIZE;
+
+		if (dtag->kmode == siap_khash_mode_merkle)
+		{
+			plen = (size_t)qsc_intutils_min(dtag->kdepth, SIAP_KTREE_DEPTH_MAX) * SIAP_KTAG_STATE_HASH;
+			output[pos] = (uint8_t)(plen / SIAP_KTAG_STATE_HASH);
+			pos += SIAP_KHASH_DEPTH_SIZE;
+			qsc_memutils_copy(output + pos, dtag->kpath, plen);
+			pos += plen;
+		}
 	}
+
+	return pos;
 }
 
 void siap_deserialize_server_key(siap_server_key* skey, const uint8_t* input)
@@ -110,6 +439,44 @@ void siap_serialize_server_key(uint8_t* output, const siap_server_key* skey)
 	}
 }
 
+void siap_deserialize_session_ticket(siap_session_ticket* ticket, const uint8_t* input)
+{
+	SIAP_ASSERT(ticket != NULL);
+	SIAP_ASSERT(input != NULL);
+
+	size_t pos;
+
+	if (ticket != NULL && input != NULL)
+	{
+		qsc_memutils_copy(ticket->kid, input, SIAP_KID_SIZE);
+		pos = SIAP_KID_SIZE;
+		ticket->issued = qsc_intutils_le8to64(input + pos);
+		pos += SIAP_EXPIRATION_SIZE;
+		ticket->expiration = qsc_intutils_le8to64(input + pos);
+		pos += SIAP_EXPIRATION_SIZE;
+		qsc_memutils_copy(ticket->mac, input + pos, SIAP_MAC_SIZE);
+	}
+}
+
+void siap_serialize_session_ticket(uint8_t* output, const siap_session_ticket* ticket)
+{
+	SIAP_ASSERT(output != NULL);
+	SIAP_ASSERT(ticket != NULL);
+
+	size_t pos;
+
+	if (output != NULL && ticket != NULL)
+	{
+		qsc_memutils_copy(output, ticket->kid, SIAP_KID_SIZE);
+		pos = SIAP_KID_SIZE;
+		qsc_intutils_le64to8(output + pos, ticket->issued);
+		pos += SIAP_EXPIRATION_SIZE;
+		qsc_intutils_le64to8(output + pos, ticket->expiration);
+		pos += SIAP_EXPIRATION_SIZE;
+		qsc_memutils_copy(output + pos, ticket->mac, SIAP_MAC_SIZE);
+	}
+}
+
 void siap_increment_device_key(siap_device_key* dkey)
 {
 	SIAP_ASSERT(dkey != NULL);
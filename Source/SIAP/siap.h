@@ -70,6 +70,13 @@
 */
 //#define SIAP_EXTENDED_ENCRYPTION
 
+/*!
+* \def SIAP_TAG_COMMITMENT
+* \brief Enable the device tag mac commitment protocol revision.
+* The device tag stores a commitment to the key tree mac and kid, and the tree is no longer hashed when authenticating.
+*/
+//#define SIAP_TAG_COMMITMENT
+
 /*!
 * \def SIAP_CLIENT_PASSWORD_MAX
 * \brief The client passphrase maximum string length
@@ -164,6 +171,36 @@
 */
 #define SIAP_KTREE_COUNT 1024
 
+/*!
+* \def SIAP_KTREE_DEPTH
+* \brief The depth of the key tree Merkle hash, log2(SIAP_KTREE_COUNT).
+*/
+#define SIAP_KTREE_DEPTH 10U
+
+/*!
+* \def SIAP_KTREE_COUNT_MIN
+* \brief The minimum number of tokens in a variable-size key tree.
+*/
+#define SIAP_KTREE_COUNT_MIN 64U
+
+/*!
+* \def SIAP_KTREE_COUNT_MAX
+* \brief The maximum number of tokens in a variable-size key tree.
+*/
+#define SIAP_KTREE_COUNT_MAX 65536U
+
+/*!
+* \def SIAP_KTREE_DEPTH_MAX
+* \brief The depth of the largest key tree Merkle hash, log2(SIAP_KTREE_COUNT_MAX).
+*/
+#define SIAP_KTREE_DEPTH_MAX 16U
+
+/*!
+* \def SIAP_KTREE_COUNT_SIZE
+* \brief The size of the token count field in a variable-size device key header.
+*/
+#define SIAP_KTREE_COUNT_SIZE 4U
+
 #if defined(SIAP_EXTENDED_ENCRYPTION)
 /*!
 * \def SIAP_KTAG_STATE_HASH
@@ -270,6 +307,25 @@
 */
 #define SIAP_KID_SIZE (SIAP_DID_SIZE + SIAP_KEY_ID_SIZE)
 
+/*!
+* \def SIAP_KHASH_MODE_SIZE
+* \brief The size of the serialized key tree hash mode identifier.
+*/
+#define SIAP_KHASH_MODE_SIZE 1U
+
+/*!
+* \def SIAP_KHASH_DEPTH_SIZE
+* \brief The size of the serialized Merkle authentication path depth.
+*/
+#define SIAP_KHASH_DEPTH_SIZE 1U
+
+/*!
+* \def SIAP_KHASH_PATH_SIZE
+* \brief The size of the largest Merkle authentication path stored in the device tag.
+* A tag serializes only the log2(count) hashes of its own key tree.
+*/
+#define SIAP_KHASH_PATH_SIZE (SIAP_KTREE_DEPTH_MAX * SIAP_KTAG_STATE_HASH)
+
 /*!
 * \def SIAP_KTREE_SIZE
 * \brief	The key tree size in bytes.
@@ -282,11 +338,79 @@
 */
 #define SIAP_DEVICE_KEY_ENCODED_SIZE ((SIAP_AUTHENTICATION_TOKEN_SIZE * SIAP_KTREE_COUNT) + SIAP_MAC_SIZE + SIAP_KID_SIZE + SIAP_EXPIRATION_SIZE)
 
+/*!
+* \def SIAP_CARD_FORMAT_SIZE
+* \brief The size of the card format identifier that starts a versioned device key.
+*/
+#define SIAP_CARD_FORMAT_SIZE 1U
+
+/*!
+* \def SIAP_KSEGMENT_TOKENS
+* \brief The number of tokens in each segment of a segmented device key.
+*/
+#define SIAP_KSEGMENT_TOKENS 16U
+
+/*!
+* \def SIAP_KSEGMENT_COUNT
+* \brief The number of segments in a segmented device key.
+*/
+#define SIAP_KSEGMENT_COUNT (SIAP_KTREE_COUNT / SIAP_KSEGMENT_TOKENS)
+
+/*!
+* \def SIAP_KSEGMENT_SIZE
+* \brief The size in bytes of the tokens in one key segment.
+*/
+#define SIAP_KSEGMENT_SIZE (SIAP_KSEGMENT_TOKENS * SIAP_AUTHENTICATION_TOKEN_SIZE)
+
+/*!
+* \def SIAP_KSEGMENT_SEQUENCE_SIZE
+* \brief The size of the key segment sequence number.
+*/
+#define SIAP_KSEGMENT_SEQUENCE_SIZE 4U
+
+/*!
+* \def SIAP_KSEGMENT_ENCODED_SIZE
+* \brief The size in bytes of one serialized key segment.
+*/
+#define SIAP_KSEGMENT_ENCODED_SIZE (SIAP_KSEGMENT_SEQUENCE_SIZE + SIAP_KSEGMENT_SIZE + SIAP_MAC_SIZE)
+
+/*!
+* \def SIAP_SEGMENTED_HEADER_ENCODED_SIZE
+* \brief The size in bytes of the serialized segmented device key header.
+* The segment at index i is serialized at offset SIAP_SEGMENTED_HEADER_ENCODED_SIZE + (i * SIAP_KSEGMENT_ENCODED_SIZE).
+*/
+#define SIAP_SEGMENTED_HEADER_ENCODED_SIZE (SIAP_CARD_FORMAT_SIZE + SIAP_KID_SIZE + SIAP_EXPIRATION_SIZE)
+
+/*!
+* \def SIAP_SEGMENTED_KEY_ENCODED_SIZE
+* \brief The size in bytes of a serialized segmented device key.
+*/
+#define SIAP_SEGMENTED_KEY_ENCODED_SIZE (SIAP_SEGMENTED_HEADER_ENCODED_SIZE + (SIAP_KSEGMENT_COUNT * SIAP_KSEGMENT_ENCODED_SIZE))
+
+/*!
+* \def SIAP_VARIABLE_HEADER_ENCODED_SIZE
+* \brief The size in bytes of the serialized variable-size device key header.
+* The encrypted key tree and its mac follow the header.
+*/
+#define SIAP_VARIABLE_HEADER_ENCODED_SIZE (SIAP_CARD_FORMAT_SIZE + SIAP_KTREE_COUNT_SIZE + SIAP_KID_SIZE + SIAP_EXPIRATION_SIZE)
+
+/*!
+* \def SIAP_TAG_FORMAT_SIZE
+* \brief The size of the format identifier that starts a versioned device tag.
+*/
+#define SIAP_TAG_FORMAT_SIZE 1U
+
+/*!
+* \def SIAP_DEVICE_TAG_ORIGINAL_SIZE
+* \brief The size in bytes of the original unversioned device tag; the key identity, the key hash and the passphrase hash.
+*/
+#define SIAP_DEVICE_TAG_ORIGINAL_SIZE (SIAP_KID_SIZE + SIAP_KTAG_STATE_HASH + SIAP_HASH_SIZE)
+
 /*!
 * \def SIAP_DEVICE_TAG_ENCODED_SIZE
-* \brief The device tag size in bytes.
+* \brief The largest serialized device tag size in bytes.
 */
-#define SIAP_DEVICE_TAG_ENCODED_SIZE (SIAP_KID_SIZE + SIAP_KTAG_STATE_HASH + SIAP_HASH_SIZE)
+#define SIAP_DEVICE_TAG_ENCODED_SIZE (SIAP_TAG_FORMAT_SIZE + SIAP_KHASH_MODE_SIZE + SIAP_SCB_COST_SIZE + SIAP_DEVICE_TAG_ORIGINAL_SIZE + SIAP_KHASH_DEPTH_SIZE + SIAP_KHASH_PATH_SIZE)
 
 /*!
 * \def SIAP_SERVER_KEY_ENCODED_SIZE
@@ -294,6 +418,18 @@
 */
 #define SIAP_SERVER_KEY_ENCODED_SIZE (SIAP_SERVER_KEY_SIZE + SIAP_SID_SIZE + SIAP_SALT_SIZE + SIAP_EXPIRATION_SIZE)
 
+/*!
+* \def SIAP_TICKET_DURATION_MAX
+* \brief The longest lifetime of a session ticket in seconds.
+*/
+#define SIAP_TICKET_DURATION_MAX 900U
+
+/*!
+* \def SIAP_TICKET_ENCODED_SIZE
+* \brief The session ticket size in bytes.
+*/
+#define SIAP_TICKET_ENCODED_SIZE (SIAP_KID_SIZE + SIAP_EXPIRATION_SIZE + SIAP_EXPIRATION_SIZE + SIAP_MAC_SIZE)
+
 /*!
  * \def SIAP_SCB_CPU_COST
  * \brief The SCB passphrase KDF CPU Cost factor.
@@ -306,6 +442,18 @@
  */
 #define SIAP_SCB_CPU_COST 1U
 
+/*!
+ * \def SIAP_SCB_CPU_COST_MAX
+ * \brief The largest SCB CPU cost factor a device tag can record, and the calibration upper bound.
+ */
+#define SIAP_SCB_CPU_COST_MAX 32U
+
+/*!
+ * \def SIAP_SCB_COST_SIZE
+ * \brief The size of the serialized SCB cost factors in a device tag, one byte for each factor.
+ */
+#define SIAP_SCB_COST_SIZE 2U
+
 /*!
  * \def SIAP_SCB_MEMORY_COST
  * \brief The SCB passphrase KDF Memory Cost factor.
@@ -318,22 +466,42 @@
  */
 #define SIAP_SCB_MEMORY_COST 1U
 
+/*!
+ * \def SIAP_SCB_MEMORY_COST_MAX
+ * \brief The largest SCB memory cost factor a device tag can record, and the calibration upper bound.
+ */
+#define SIAP_SCB_MEMORY_COST_MAX 16U
+
 /* error code strings */
 
-#if defined(SIAP_EXTENDED_ENCRYPTION)
+#if defined(SIAP_TAG_COMMITMENT)
+#	if defined(SIAP_EXTENDED_ENCRYPTION)
+/*!
+* \brief The SIAP configuration string for 512-bit security, with the tag mac commitment.
+*/
+static const char SIAP_CONFIG_STRING[SIAP_CONFIG_SIZE + 1U] = "r02-siap-rcs512-keccak512";
+#	else
+/*!
+* \brief The SIAP configuration string for 256-bit security, with the tag mac commitment.
+*/
+static const char SIAP_CONFIG_STRING[SIAP_CONFIG_SIZE + 1U] = "r03-siap-rcs256-keccak256";
+#	endif
+#else
+#	if defined(SIAP_EXTENDED_ENCRYPTION)
 /*!
 * \brief The SIAP configuration string for 256-bit security.
 */
 static const char SIAP_CONFIG_STRING[SIAP_CONFIG_SIZE + 1U] = "r01-siap-rcs512-keccak512";
-#else
+#	else
 /*!
 * \brief The SIAP configuration string for 256-bit security.
 */
 static const char SIAP_CONFIG_STRING[SIAP_CONFIG_SIZE + 1U] = "r02-siap-rcs256-keccak256";
+#	endif
 #endif
 
 /** \cond */
-#define SIAP_ERROR_STRING_DEPTH 13U
+#define SIAP_ERROR_STRING_DEPTH 15U
 #define SIAP_ERROR_STRING_WIDTH 128U
 
 static const char SIAP_ERROR_STRINGS[SIAP_ERROR_STRING_DEPTH][SIAP_ERROR_STRING_WIDTH] =
@@ -351,6 +519,8 @@ static const char SIAP_ERROR_STRINGS[SIAP_ERROR_STRING_DEPTH][SIAP_ERROR_STRING_
 	"The file could not be read",
 	"The file path specified is invalid",
 	"The file is locked or unavailable",
+	"The request deadline has passed",
+	"The server is overloaded",
 };
 /** \endcond */
 
@@ -373,9 +543,48 @@ SIAP_EXPORT_API typedef enum siap_errors
 	siap_error_token_not_created = 0x09U,		/*!< The server could not generate the token */
 	siap_error_file_read_failure = 0x0AU,		/*!< The file could not be read */
 	siap_error_file_invalid_path = 0x0BU,		/*!< The file path specified is invalid */
-	siap_error_file_copy_failure = 0x0CU		/*!< The file is locked or unavailable */
+	siap_error_file_copy_failure = 0x0CU,		/*!< The file is locked or unavailable */
+	siap_error_deadline_expired = 0x0DU,		/*!< The request deadline has passed */
+	siap_error_server_overloaded = 0x0EU		/*!< The server is overloaded */
 } siap_errors;
 
+/*!
+ * \enum siap_khash_modes
+ * \brief The key tree hash modes.
+ * The mode is stored in the device tag and selects the function used to compute the tag khash.
+ */
+SIAP_EXPORT_API typedef enum siap_khash_modes
+{
+	siap_khash_mode_serial = 0x00U,				/*!< SHAKE over the entire key tree */
+	siap_khash_mode_parallel = 0x01U,			/*!< ParallelHash over fixed size key tree blocks */
+	siap_khash_mode_merkle = 0x02U,				/*!< Merkle tree over the key tree tokens */
+	siap_khash_mode_segment = 0x03U,			/*!< Commitment to the mac of the active segment of a segmented key */
+	siap_khash_mode_commitment = 0x04U			/*!< Commitment to the key tree mac and kid, requires SIAP_TAG_COMMITMENT */
+} siap_khash_modes;
+
+/*!
+ * \enum siap_tag_formats
+ * \brief The device tag formats.
+ * The original device tag carries no format identifier and is recognized by its size; versioned tags begin with one of these values.
+ */
+SIAP_EXPORT_API typedef enum siap_tag_formats
+{
+	siap_tag_format_original = 0x00U,			/*!< The key identity, key hash and passphrase hash, unversioned and always serial */
+	siap_tag_format_versioned = 0x01U			/*!< The format, hash mode and passphrase costs, the original fields, then the Merkle path in the Merkle mode */
+} siap_tag_formats;
+
+/*!
+ * \enum siap_card_formats
+ * \brief The device key card formats.
+ * The original device key encoding carries no format identifier; versioned formats begin with one of these values.
+ */
+SIAP_EXPORT_API typedef enum siap_card_formats
+{
+	siap_card_format_monolithic = 0x00U,		/*!< The whole key tree under a single mac, unversioned */
+	siap_card_format_segmented = 0x01U,			/*!< Independently encrypted and authenticated key segments */
+	siap_card_format_variable = 0x02U			/*!< A key tree of any supported size under a single mac */
+} siap_card_formats;
+
 /*!
  * \struct siap_device_key
  * \brief The SIAP device key structure.
@@ -388,6 +597,44 @@ SIAP_EXPORT_API typedef struct siap_device_key
 	uint64_t expiration;						/*!< The expiration time in seconds from epoch */
 } siap_device_key;
 
+/*!
+ * \struct siap_key_segment
+ * \brief A segment of a segmented device key.
+ * Each segment is encrypted and authenticated on its own, under a key derived from the device identity and the
+ * key counter value at the time the segment was last encrypted.
+ */
+SIAP_EXPORT_API typedef struct siap_key_segment
+{
+	uint8_t stree[SIAP_KSEGMENT_SIZE + SIAP_MAC_SIZE];	/*!< The segment tokens followed by the segment mac */
+	uint32_t sequence;							/*!< The key counter value the segment was encrypted under */
+} siap_key_segment;
+
+/*!
+ * \struct siap_segmented_key
+ * \brief The SIAP segmented device key structure.
+ * The header, the key identity and expiration, is bound to every segment as associated data.
+ */
+SIAP_EXPORT_API typedef struct siap_segmented_key
+{
+	siap_key_segment segments[SIAP_KSEGMENT_COUNT];	/*!< The key segments */
+	uint8_t kid[SIAP_KID_SIZE];					/*!< The key device identity array */
+	uint64_t expiration;						/*!< The expiration time in seconds from epoch */
+} siap_segmented_key;
+
+/*!
+ * \struct siap_variable_key
+ * \brief The SIAP variable-size device key structure.
+ * The key tree holds a power of two number of tokens between \c SIAP_KTREE_COUNT_MIN and \c SIAP_KTREE_COUNT_MAX,
+ * and is allocated by \c siap_variable_key_initialize or \c siap_deserialize_variable_key.
+ */
+SIAP_EXPORT_API typedef struct siap_variable_key
+{
+	uint8_t* ktree;								/*!< The device token tree followed by the mac */
+	uint32_t kcount;							/*!< The number of tokens in the tree */
+	uint8_t kid[SIAP_KID_SIZE];					/*!< The key device identity array */
+	uint64_t expiration;						/*!< The expiration time in seconds from epoch */
+} siap_variable_key;
+
 /*!
  * \struct siap_key_tag
  * \brief The SIAP server device tag structure.
@@ -395,9 +642,14 @@ SIAP_EXPORT_API typedef struct siap_device_key
  */
 SIAP_EXPORT_API typedef struct siap_device_tag
 {
+	siap_khash_modes kmode;						/*!< The key tree hash mode */
+	uint8_t cpucost;							/*!< The SCB CPU cost of the passphrase hash, zero is SIAP_SCB_CPU_COST */
+	uint8_t memcost;							/*!< The SCB memory cost of the passphrase hash, zero is SIAP_SCB_MEMORY_COST */
 	uint8_t kid[SIAP_KID_SIZE];					/*!< The key device key identity array */
 	uint8_t khash[SIAP_KTAG_STATE_HASH];		/*!< The hash of the device key */
 	uint8_t phash[SIAP_HASH_SIZE];				/*!< The passphrase hash */
+	uint8_t kdepth;								/*!< The number of hashes in the Merkle authentication path, zero in the other modes */
+	uint8_t kpath[SIAP_KHASH_PATH_SIZE];		/*!< The Merkle authentication path of the current token */
 } siap_device_tag;
 
 /*!
@@ -413,6 +665,20 @@ SIAP_EXPORT_API typedef struct siap_server_key
 	uint64_t expiration;						/*!< The expiration time in seconds from epoch */
 } siap_server_key;
 
+/*!
+ * \struct siap_session_ticket
+ * \brief The SIAP session ticket structure.
+ * A short-lived ticket issued after a successful authentication, that lets the device re-authenticate without
+ * spending another token. The ticket is a bearer credential, and must only be sent over an authenticated channel.
+ */
+SIAP_EXPORT_API typedef struct siap_session_ticket
+{
+	uint8_t kid[SIAP_KID_SIZE];					/*!< The identity of the token the ticket was issued for */
+	uint64_t issued;							/*!< The issue time in seconds from epoch */
+	uint64_t expiration;						/*!< The expiration time in seconds from epoch */
+	uint8_t mac[SIAP_MAC_SIZE];					/*!< The ticket mac, keyed by the server key and the token */
+} siap_session_ticket;
+
 /**
  * \brief Deserialize a client device key.
  * This function deserializes a byte array into a SIAP device key structure.
@@ -431,6 +697,120 @@ SIAP_EXPORT_API void siap_deserialize_device_key(siap_device_key* dkey, const ui
  */
 SIAP_EXPORT_API void siap_serialize_device_key(uint8_t* output, const siap_device_key* dkey);
 
+/**
+ * \brief Deserialize one segment of a segmented device key.
+ *
+ * \param segment A pointer to the output key segment.
+ * \param input [const] The input serialized segment array of size \c SIAP_KSEGMENT_ENCODED_SIZE.
+ */
+SIAP_EXPORT_API void siap_deserialize_key_segment(siap_key_segment* segment, const uint8_t* input);
+
+/**
+ * \brief Serialize one segment of a segmented device key.
+ *
+ * \param output The output byte array of size \c SIAP_KSEGMENT_ENCODED_SIZE.
+ * \param segment [const] A pointer to the key segment.
+ */
+SIAP_EXPORT_API void siap_serialize_key_segment(uint8_t* output, const siap_key_segment* segment);
+
+/**
+ * \brief Deserialize a segmented device key.
+ *
+ * \param dkey A pointer to the output segmented device key structure.
+ * \param input [const] The input serialized key array of size \c SIAP_SEGMENTED_KEY_ENCODED_SIZE.
+ *
+ * \return Returns false if the input is not a segmented device key.
+ */
+SIAP_EXPORT_API bool siap_deserialize_segmented_key(siap_segmented_key* dkey, const uint8_t* input);
+
+/**
+ * \brief Serialize a segmented device key.
+ *
+ * \param output The output byte array of size \c SIAP_SEGMENTED_KEY_ENCODED_SIZE.
+ * \param dkey [const] A pointer to the segmented device key structure.
+ */
+SIAP_EXPORT_API void siap_serialize_segmented_key(uint8_t* output, const siap_segmented_key* dkey);
+
+/**
+ * \brief Deserialize the header of a segmented device key.
+ * Only the key identity and expiration are read, so a server can load the header and the active segment alone.
+ *
+ * \param dkey A pointer to the output segmented device key structure.
+ * \param input [const] The input serialized header array of size \c SIAP_SEGMENTED_HEADER_ENCODED_SIZE.
+ *
+ * \return Returns false if the input is not a segmented device key header.
+ */
+SIAP_EXPORT_API bool siap_deserialize_segmented_key_header(siap_segmented_key* dkey, const uint8_t* input);
+
+/**
+ * \brief Serialize the header of a segmented device key.
+ *
+ * \param output The output byte array of size \c SIAP_SEGMENTED_HEADER_ENCODED_SIZE.
+ * \param dkey [const] A pointer to the segmented device key structure.
+ */
+SIAP_EXPORT_API void siap_serialize_segmented_key_header(uint8_t* output, const siap_segmented_key* dkey);
+
+/**
+ * \brief Deserialize a variable-size device key.
+ * The key tree is allocated to the size given in the header, and must be released with \c siap_variable_key_dispose.
+ *
+ * \param vkey A pointer to the output variable-size device key structure.
+ * \param input [const] The input serialized key array.
+ * \param inplen The length of the input array.
+ *
+ * \return Returns false if the input is not a variable-size device key, or the length does not match the header.
+ */
+SIAP_EXPORT_API bool siap_deserialize_variable_key(siap_variable_key* vkey, const uint8_t* input, size_t inplen);
+
+/**
+ * \brief Deserialize a variable-size device key into a caller key tree buffer.
+ * Nothing is allocated; the key tree points at the buffer, and the key must not be released with \c siap_variable_key_dispose.
+ *
+ * \param vkey A pointer to the output variable-size device key structure.
+ * \param ktree The key tree buffer, of size \c capacity * SIAP_AUTHENTICATION_TOKEN_SIZE + SIAP_MAC_SIZE.
+ * \param capacity The number of tokens the buffer can hold.
+ * \param input [const] The input serialized key array.
+ * \param inplen The length of the input array.
+ *
+ * \return Returns false if the input is not a variable-size device key, the length does not match the header,
+ * or the key tree is larger than the buffer.
+ */
+SIAP_EXPORT_API bool siap_deserialize_variable_key_buffer(siap_variable_key* vkey, uint8_t* ktree, uint32_t capacity, const uint8_t* input, size_t inplen);
+
+/**
+ * \brief Serialize a variable-size device key.
+ *
+ * \param output The output byte array of size \c siap_variable_key_encoded_size(vkey->kcount).
+ * \param vkey [const] A pointer to the variable-size device key structure.
+ */
+SIAP_EXPORT_API void siap_serialize_variable_key(uint8_t* output, const siap_variable_key* vkey);
+
+/**
+ * \brief Dispose of a variable-size device key, erasing and releasing the key tree.
+ *
+ * \param vkey A pointer to the variable-size device key structure.
+ */
+SIAP_EXPORT_API void siap_variable_key_dispose(siap_variable_key* vkey);
+
+/**
+ * \brief Get the serialized size of a variable-size device key.
+ *
+ * \param count The number of tokens in the key tree.
+ *
+ * \return Returns the encoded size in bytes.
+ */
+SIAP_EXPORT_API size_t siap_variable_key_encoded_size(uint32_t count);
+
+/**
+ * \brief Initialize a variable-size device key and allocate the key tree.
+ *
+ * \param vkey A pointer to the variable-size device key structure.
+ * \param count The number of tokens, a power of two between \c SIAP_KTREE_COUNT_MIN and \c SIAP_KTREE_COUNT_MAX.
+ *
+ * \return Returns false if the count is not supported or the allocation failed.
+ */
+SIAP_EXPORT_API bool siap_variable_key_initialize(siap_variable_key* vkey, uint32_t count);
+
 /**
  * \brief Return a string description of an SIAP error code.
  * This function returns a human-readable string corresponding to the provided SIAP error code.
@@ -468,20 +848,36 @@ SIAP_EXPORT_API void siap_log_system_error(siap_errors err);
 /**
  * \brief Deserialize a device tag from a byte array.
  * This function deserializes a byte array into a SIAP device tag structure.
+ * A tag of \c SIAP_DEVICE_TAG_ORIGINAL_SIZE bytes is read as an original tag in serial mode with the default passphrase costs.
  *
  * \param dtag A pointer to the output SIAP device tag structure.
- * \param input [const] The input serialized device tag array of size \c SIAP_DEVICE_TAG_ENCODED_SIZE.
+ * \param input [const] The input serialized device tag array.
+ * \param inplen The length of the serialized device tag in bytes.
+ *
+ * \return Returns false if the format or the hash mode is unknown, a passphrase cost exceeds its maximum,
+ * or the length does not match the encoding.
  */
-SIAP_EXPORT_API void siap_deserialize_device_tag(siap_device_tag* dtag, const uint8_t* input);
+SIAP_EXPORT_API bool siap_deserialize_device_tag(siap_device_tag* dtag, const uint8_t* input, size_t inplen);
+
+/**
+ * \brief Get the serialized size of a device tag.
+ *
+ * \param dtag [const] A pointer to the SIAP device tag structure.
+ *
+ * \return Returns the number of bytes written by \c siap_serialize_device_tag.
+ */
+SIAP_EXPORT_API size_t siap_device_tag_encoded_size(const siap_device_tag* dtag);
 
 /**
  * \brief Serialize a device tag into a byte array.
- * This function serializes a SIAP device tag structure into a byte array.
+ * This function serializes a SIAP device tag structure into a byte array, always in the versioned format.
  *
- * \param output The output byte array to hold the serialized device tag of size \c SIAP_DEVICE_TAG_ENCODED_SIZE.
+ * \param output The output byte array to hold the serialized device tag, of at least \c SIAP_DEVICE_TAG_ENCODED_SIZE bytes.
  * \param dtag [const] A pointer to the input SIAP device tag structure.
+ *
+ * \return Returns the number of bytes written.
  */
-SIAP_EXPORT_API void siap_serialize_device_tag(uint8_t* output, const siap_device_tag* dtag);
+SIAP_EXPORT_API size_t siap_serialize_device_tag(uint8_t* output, const siap_device_tag* dtag);
 
 /**
  * \brief Deserialize a server key from a byte array.
@@ -501,6 +897,22 @@ SIAP_EXPORT_API void siap_deserialize_server_key(siap_server_key* skey, const ui
  */
 SIAP_EXPORT_API void siap_serialize_server_key(uint8_t* output, const siap_server_key* skey);
 
+/**
+ * \brief Deserialize a session ticket from a byte array.
+ *
+ * \param ticket A pointer to the output session ticket.
+ * \param input [const] The input serialized ticket array of size \c SIAP_TICKET_ENCODED_SIZE.
+ */
+SIAP_EXPORT_API void siap_deserialize_session_ticket(siap_session_ticket* ticket, const uint8_t* input);
+
+/**
+ * \brief Serialize a session ticket into a byte array.
+ *
+ * \param output The output byte array of size \c SIAP_TICKET_ENCODED_SIZE.
+ * \param ticket [const] A pointer to the session ticket.
+ */
+SIAP_EXPORT_API void siap_serialize_session_ticket(uint8_t* output, const siap_session_ticket* ticket);
+
 /**
  * \brief Increment the device key
  * This function clears a key at the current position and increments the kid counter.
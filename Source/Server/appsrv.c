@@ -1,5 +1,6 @@
 #include "appsrv.h"
 #include "logger.h"
+#include "profile.h"
 #include "siap.h"
 #include "server.h"
 #include "consoleutils.h"
@@ -149,6 +150,7 @@ static bool server_key_dialogue(void)
 	char fpath[QSC_SYSTEM_MAX_PATH] = { 0 };
 	size_t ctr;
 	size_t len;
+	size_t tlen;
 	siap_errors err;
 	bool res;
 
@@ -179,7 +181,21 @@ static bool server_key_dialogue(void)
 				qsc_fileutils_exists(dpath) && 
 				qsc_stringutils_string_contains(dpath, SIAP_DEVICE_KEY_NAME) == true)
 			{
-				res = qsc_fileutils_copy_file_to_stream(dpath, (char*)dskey, sizeof(dskey));
+				const siap_profile* kprof;
+
+				/* a device key issued for the other security profile is refused, only a server built for that profile can read it */
+				kprof = siap_profile_from_device_key_size(qsc_fileutils_get_size(dpath));
+				res = (kprof == siap_profile_native());
+
+				if (res == true)
+				{
+					res = qsc_fileutils_copy_file_to_stream(dpath, (char*)dskey, sizeof(dskey));
+				}
+				else if (kprof != NULL)
+				{
+					server_print_string("server> The device-key was issued for another security profile: ");
+					server_print_line(kprof->config);
+				}
 
 				if (res == true)
 				{
@@ -195,19 +211,28 @@ static bool server_key_dialogue(void)
 
 					if (res == true)
 					{
-						/* hash the passphrase with SCB */
-						siap_server_passphrase_hash_generate(phash, upass, len);
-
 						/* get the device tag */
 						server_get_path(fpath, sizeof(fpath), SIAP_USER_DATABASE_NAME);
-						res = qsc_fileutils_copy_file_to_stream(fpath, (char*)dstag, sizeof(dstag));
+						tlen = qsc_fileutils_get_size(fpath);
+						res = (tlen <= sizeof(dstag) && qsc_fileutils_copy_file_to_stream(fpath, (char*)dstag, tlen) == true);
 
-						if (res == true)
+						if (res == false)
+						{
+							siap_log_system_error(siap_error_file_copy_failure);
+						}
+						else if (siap_deserialize_device_tag(&dtag, dstag, tlen) == false)
+						{
+							/* the tag format or hash mode is unknown */
+							siap_log_system_error(siap_error_invalid_input);
+							res = false;
+						}
+						else
 						{
-							/* deserialize the tag */
-							siap_deserialize_device_tag(&dtag, dstag);
 							server_print_message("The device-key has been loaded.");
 
+							/* hash the passphrase with SCB, using the costs recorded in the tag; the tag decoder bounds the costs */
+							(void)siap_server_passphrase_hash_generate_costs(phash, upass, len, dtag.cpucost, dtag.memcost);
+
 							/* authenticate the key; the output token can be used as a symmetric key */
 							err = siap_server_authenticate_device(dtok, &dkey, &dtag, &skey, phash);
 
@@ -223,18 +248,14 @@ static bool server_key_dialogue(void)
 
 							/* Important! authenticate updates the structures, so re-save the key and database entry */
 
-							/* re-save the device tag */
-							siap_serialize_device_tag(dstag, &dtag);
-							qsc_fileutils_copy_stream_to_file(fpath, (char*)dstag, sizeof(dstag));
+							/* re-save the device tag, an original tag is rewritten in the versioned format */
+							tlen = siap_serialize_device_tag(dstag, &dtag);
+							qsc_fileutils_copy_stream_to_file(fpath, (char*)dstag, tlen);
 
 							/* re-save the device key */
 							siap_serialize_device_key(dskey, &dkey);
 							qsc_fileutils_copy_stream_to_file(dpath, (char*)dskey, sizeof(dskey));
 						}
-						else
-						{
-							siap_log_system_error(siap_error_file_copy_failure);
-						}
 					}
 					else
 					{
@@ -319,24 +340,36 @@ static bool server_key_dialogue(void)
 
 				/* create and store the database entry */
 
-				/* hash the passphrase with SCB */
-				siap_server_passphrase_hash_generate(phash, upass, SIAP_HASH_SIZE);
-				/* generate the device tag */
+				/* hash the passphrase with SCB, and record the costs in the device tag */
+				dtag.cpucost = SIAP_SCB_CPU_COST;
+				dtag.memcost = SIAP_SCB_MEMORY_COST;
+				(void)siap_server_passphrase_hash_generate_costs(phash, upass, SIAP_HASH_SIZE, dtag.cpucost, dtag.memcost);
+#if defined(SIAP_TAG_COMMITMENT)
+				/* encrypt the device key, and commit the device tag to the key mac */
+				siap_server_encrypt_device_key(&dkey, &skey, phash);
+				dtag.kmode = siap_khash_mode_commitment;
+				siap_server_generate_device_tag(&dtag, &dkey, phash);
+#else
+				/* generate the device tag, new enrollments use the Merkle key tree hash */
+				dtag.kmode = siap_khash_mode_merkle;
 				siap_server_generate_device_tag(&dtag, &dkey, phash);
+#endif
 
 				/* serialize the tag and store it */
-				siap_serialize_device_tag(dstag, &dtag);
+				tlen = siap_serialize_device_tag(dstag, &dtag);
 				/* this would be stored in a server's secure database along with the server key */
 				server_get_path(fpath, sizeof(fpath), SIAP_USER_DATABASE_NAME);
-				res = qsc_fileutils_copy_stream_to_file(fpath, (char*)dstag, sizeof(dstag));
+				res = qsc_fileutils_copy_stream_to_file(fpath, (char*)dstag, tlen);
 
 				if (res == true)
 				{
 					server_print_string("server> The database has been saved to ");
 					server_print_line(fpath);
 
+#if !defined(SIAP_TAG_COMMITMENT)
 					/* encrypt the device key */
 					siap_server_encrypt_device_key(&dkey, &skey, phash);
+#endif
 
 					/* serialize the device key and save it to a file */
 					server_get_path(fpath, sizeof(fpath), SIAP_DEVICE_KEY_NAME);